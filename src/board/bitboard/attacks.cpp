@@ -2,41 +2,156 @@
 
 namespace board::bitboards::attacks {
 
-utils::mdarray<bitboard, constants::num_squares, max_bishop_blockers_config> bishop_attacks;
-utils::mdarray<bitboard, constants::num_squares, max_rook_blockers_config>   rook_attacks;
+/// @brief Generation of the sliding attack tables at compile time. The tables are large, so the
+/// constant evaluation has to be as cheap as possible: Attacks are computed from precalculated
+/// rays instead of walking the board, and blocker configurations are enumerated with the
+/// Carry-Rippler trick
+/// @note Generating the tables needs more constexpr operations than the compilers allow by
+/// default, see the build files
+namespace {
 
-/// @brief Initializes the sliding attacks lookup tables
-/// @tparam PieceType Piece type (Slider)
-template <piece_type PieceType>
-void init_sliders() {
-    constexpr bool is_bishop = PieceType == piece_type::bishop;
+/// @brief Ray directions, the first half increasing the square index and the second one
+/// decreasing it, in the same order so that opposite rays are half the enum apart
+enum ray : u8 {
+    north,
+    east,
+    north_east,
+    north_west,
+    south,
+    west,
+    south_west,
+    south_east,
+    num_rays
+};
 
+/// @brief Squares a slider attacks in every direction on an empty board
+constexpr auto empty_board_rays = [] {
+    utils::mdarray<bitboard, num_rays, constants::num_squares> rays;
+
+    for (u8 i = 0; i < constants::num_squares; ++i) {
+        const auto sq = static_cast<square>(i);
+
+        rays[north, i]      = sliding_attacks<direction::north>(sq, util::empty_bb);
+        rays[east, i]       = sliding_attacks<direction::east>(sq, util::empty_bb);
+        rays[north_east, i] = sliding_attacks<direction::north_east>(sq, util::empty_bb);
+        rays[north_west, i] = sliding_attacks<direction::north_west>(sq, util::empty_bb);
+        rays[south, i]      = sliding_attacks<direction::south>(sq, util::empty_bb);
+        rays[west, i]       = sliding_attacks<direction::west>(sq, util::empty_bb);
+        rays[south_west, i] = sliding_attacks<direction::south_west>(sq, util::empty_bb);
+        rays[south_east, i] = sliding_attacks<direction::south_east>(sq, util::empty_bb);
+    }
+
+    return rays;
+}();
+
+/// @brief Gets the attacks along a ray, which stop at the first blocker
+constexpr u64 ray_attacks(const ray r, const u8 sq, const u64 occupied) {
+    const u64 attacks  = empty_board_rays[r, sq].as_u64();
+    const u64 blockers = attacks & occupied;
+
+    if (blockers == 0ULL)
+        return attacks;
+
+    const int first_blocker =
+        r < south ? std::countr_zero(blockers) : 63 - std::countl_zero(blockers);
+
+    return attacks ^ empty_board_rays[r, first_blocker].as_u64();
+}
+
+constexpr u64 bishop_attacks(const u8 sq, const u64 occupied) {
+    return ray_attacks(north_east, sq, occupied) | ray_attacks(north_west, sq, occupied)
+         | ray_attacks(south_east, sq, occupied) | ray_attacks(south_west, sq, occupied);
+}
+
+constexpr u64 rook_attacks(const u8 sq, const u64 occupied) {
+    return ray_attacks(north, sq, occupied) | ray_attacks(east, sq, occupied)
+         | ray_attacks(south, sq, occupied) | ray_attacks(west, sq, occupied);
+}
+
+/// @brief Fills the packed attack table of a slider
+/// @tparam UsePext Whether the table is indexed by PEXT or by magic multiplication
+template <bool UsePext>
+constexpr void
+fill_slider_attacks(std::array<bitboard, slider_table_size>&                        table,
+                    const std::array<magics::magic_entry, constants::num_squares>& entries,
+                    u64 (*slider_attacks)(u8, u64)) {
     for (u8 sq = 0; sq < constants::num_squares; ++sq) {
-        auto [mask, magic, shift] = is_bishop ? magics::bishop_magics[sq] : magics::rook_magics[sq];
-        const int n_bits          = mask.bit_count();
-        const int num_occupancies = 1 << n_bits;
-
-        for (int i = 0; i < num_occupancies; ++i) {
-            const bitboard occupied = magics::set_blockers(i, n_bits, mask);
-#ifndef USE_PEXT
-            const auto magic_index = (occupied.as_u64() * magic) >> shift;
-#else
-            const auto magic_index = _pext_u64(occupied.as_u64(), mask.as_u64());
-#endif
-
-            if constexpr (is_bishop)
-                bishop_attacks[sq, magic_index] =
-                    gen_sliding<PieceType>(static_cast<square>(sq), occupied);
-            else
-                rook_attacks[sq, magic_index] =
-                    gen_sliding<PieceType>(static_cast<square>(sq), occupied);
+        const auto& entry           = entries[sq];
+        const u64   mask            = entry.mask.as_u64();
+        const int   num_occupancies = 1 << entry.mask.bit_count();
+
+        // The Carry-Rippler enumerates the subsets of the mask in the same order PEXT maps them,
+        // so the PEXT index of a subset is its position in the enumeration
+        u64 occupied = 0ULL;
+
+        for (int i = 0; i < num_occupancies; ++i, occupied = (occupied - mask) & mask) {
+            const u64 index =
+                UsePext ? static_cast<u64>(i) : magics::magic_index(entry, bitboard(occupied));
+
+            table[entry.offset + index] = bitboard(slider_attacks(sq, occupied));
         }
     }
 }
 
-void init() {
-    init_sliders<piece_type::bishop>();
-    init_sliders<piece_type::rook>();
+template <bool UsePext>
+constexpr std::array<bitboard, slider_table_size> generate_slider_attacks() {
+    std::array<bitboard, slider_table_size> table{};
+
+    fill_slider_attacks<UsePext>(table, magics::bishop_magics, bishop_attacks);
+    fill_slider_attacks<UsePext>(table, magics::rook_magics, rook_attacks);
+
+    return table;
 }
 
-} // namespace board::bitboards::attacks
\ No newline at end of file
+/// @brief Gets the opposite direction of a ray
+constexpr ray opposite(const ray r) { return static_cast<ray>((r + south) % num_rays); }
+
+constexpr auto generate_between_squares() {
+    utils::mdarray<bitboard, constants::num_squares, constants::num_squares> between;
+
+    for (u8 sq1 = 0; sq1 < constants::num_squares; ++sq1) {
+        for (u8 r = 0; r < num_rays; ++r) {
+            const bitboard ray_bb = empty_board_rays[r, sq1];
+
+            // The squares between are the ones of the ray before reaching the second square
+            for (bitboard targets = ray_bb; !targets.empty();) {
+                const int sq2 = targets.pop_lsb();
+                between[sq1, sq2] = ray_bb ^ empty_board_rays[r, sq2]
+                                  ^ bitboard::from_square(static_cast<square>(sq2));
+            }
+        }
+    }
+
+    return between;
+}
+
+constexpr auto generate_line_through() {
+    utils::mdarray<bitboard, constants::num_squares, constants::num_squares> line;
+
+    for (u8 sq1 = 0; sq1 < constants::num_squares; ++sq1) {
+        for (u8 r = 0; r < num_rays; ++r) {
+            const bitboard line_bb = empty_board_rays[r, sq1]
+                                   | empty_board_rays[opposite(static_cast<ray>(r)), sq1]
+                                   | bitboard::from_square(static_cast<square>(sq1));
+
+            for (bitboard targets = empty_board_rays[r, sq1]; !targets.empty();)
+                line[sq1, targets.pop_lsb()] = line_bb;
+        }
+    }
+
+    return line;
+}
+
+} // namespace
+
+constexpr std::array<bitboard, slider_table_size> magic_slider_attacks =
+    generate_slider_attacks<false>();
+constexpr std::array<bitboard, slider_table_size> pext_slider_attacks =
+    generate_slider_attacks<true>();
+
+constexpr utils::mdarray<bitboard, constants::num_squares, constants::num_squares>
+    between_squares = generate_between_squares();
+constexpr utils::mdarray<bitboard, constants::num_squares, constants::num_squares> line_through =
+    generate_line_through();
+
+} // namespace board::bitboards::attacks
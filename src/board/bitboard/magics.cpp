@@ -96,21 +96,23 @@ constexpr magic_entry find_magic(const square sq) {
 template <piece_type PieceType>
 void print_magics_by_piece_type() {
     std::cout << std::format(
-        "inline constexpr std::array<magic_entry, constants::num_squares> {} = {}\n {}",
-        PieceType == piece_type::bishop ? "bishop_magics" : "rook_magics", "{", "{")
+        "inline constexpr std::array<magic_entry, constants::num_squares> {} = pack(\n    {}",
+        PieceType == piece_type::bishop ? "bishop_magics" : "rook_magics", "{{")
               << std::endl;
 
     for (u8 sq = 0; sq < constants::num_squares; ++sq) {
-        auto [mask, magic, shift] = find_magic<PieceType>(static_cast<square>(sq));
-        std::cout << std::format(" magic_entry(bitboard(0x{:016X}ULL), 0x{:016X}ULL, {})",
-                                 mask.as_u64(), magic, shift);
+        const magic_entry entry = find_magic<PieceType>(static_cast<square>(sq));
+        std::cout << std::format("      magic_entry(bitboard(0x{:016X}ULL), 0x{:016X}ULL, {})",
+                                 entry.mask.as_u64(), entry.magic, entry.shift);
 
         if (sq < constants::num_squares - 1)
             std::cout << ",";
 
         std::cout << std::endl;
     }
-    std::cout << std::format(" {}\n{};\n", "}", "}") << std::endl;
+    std::cout << std::format("    {},\n    {});\n", "}}",
+                             PieceType == piece_type::bishop ? "0" : "table_size(bishop_magics)")
+              << std::endl;
 }
 
 void print_magics() {
@@ -1,12 +1,17 @@
 #include "position.hpp"
 
+#include <algorithm>
 #include <format>
 #include <iostream>
+#include <limits>
 
 #include "piece.hpp"
 
 #include "bitboard/attacks.hpp"
 
+#include "../eval/nnue.hpp"
+#include "../eval/psqt.hpp"
+#include "../utils/io.hpp"
 #include "../utils/parsing.hpp"
 #include "../utils/split.hpp"
 #include "../utils/zobrist.hpp"
@@ -75,8 +80,6 @@ position::position(const std::string& fen) :
     else
         throw std::runtime_error("Failed to parse fullmove number.\n");
 
-    m_hash_history.reserve(constants::max_game_ply - m_full_move_number);
-
     m_checkers_bb = attacks_to_king(king_square(m_stm), m_stm);
 
     if (!is_valid())
@@ -151,6 +154,23 @@ bitboards::bitboard position::attacks_to_king(const square kingSquare, const col
          | (bitboards::attacks::get_king_attacks(kingSquare) & opp_king);
 }
 
+bitboards::bitboard position::attackers_to(const square                sq,
+                                           const bitboards::bitboard& occupied) const {
+    const auto& queens         = piece_type_bb(piece_type::queen);
+    const auto& bishops_queens = piece_type_bb(piece_type::bishop) | queens;
+    const auto& rooks_queens   = piece_type_bb(piece_type::rook) | queens;
+    const auto& pawns          = piece_type_bb(piece_type::pawn);
+
+    return (bitboards::attacks::get_pawn_attacks(sq, color::white) & pawns
+            & occupancies(color::black))
+         | (bitboards::attacks::get_pawn_attacks(sq, color::black) & pawns
+            & occupancies(color::white))
+         | (bitboards::attacks::get_knight_attacks(sq) & piece_type_bb(piece_type::knight))
+         | (bitboards::attacks::get_bishop_attacks(sq, occupied) & bishops_queens)
+         | (bitboards::attacks::get_rook_attacks(sq, occupied) & rooks_queens)
+         | (bitboards::attacks::get_king_attacks(sq) & piece_type_bb(piece_type::king));
+}
+
 square position::king_square(const color c) const {
     return static_cast<square>((piece_type_bb(piece_type::king) & occupancies(c)).pop_lsb());
 }
@@ -163,6 +183,12 @@ void position::set_piece(const piece p, const square sq) {
     bitboards::bitboard::set_bit(m_occupied_bb[std::to_underlying(pieces::piece_color(p))], sq);
 
     m_key ^= utils::zobrist::get_piece_key(p, sq);
+
+    if (pieces::piece_to_piece_type(p) == piece_type::pawn)
+        m_pawn_key ^= utils::zobrist::get_piece_key(p, sq);
+
+    m_psqt_score += eval::psqt[std::to_underlying(p)][std::to_underlying(sq)];
+    m_game_phase += eval::game_phase_increments[std::to_underlying(pieces::piece_to_piece_type(p))];
 }
 
 void position::remove_piece(const piece p, const square sq) {
@@ -173,6 +199,19 @@ void position::remove_piece(const piece p, const square sq) {
     bitboards::bitboard::clear_bit(m_occupied_bb[std::to_underlying(pieces::piece_color(p))], sq);
 
     m_key ^= utils::zobrist::get_piece_key(p, sq);
+
+    if (pieces::piece_to_piece_type(p) == piece_type::pawn)
+        m_pawn_key ^= utils::zobrist::get_piece_key(p, sq);
+
+    m_psqt_score -= eval::psqt[std::to_underlying(p)][std::to_underlying(sq)];
+    m_game_phase -= eval::game_phase_increments[std::to_underlying(pieces::piece_to_piece_type(p))];
+}
+
+void position::set_accumulators(eval::nnue::accumulator_stack* accumulators) {
+    m_accumulators = accumulators;
+
+    if (m_accumulators != nullptr)
+        m_accumulators->reset(*this);
 }
 
 void position::move_piece(const piece p, const square from, const square to) {
@@ -180,26 +219,96 @@ void position::move_piece(const piece p, const square from, const square to) {
     set_piece(p, to);
 }
 
-template <bool SaveHashHistory>
+/// @brief Gets the squares the rook moves from and to when castling
+/// @param king_to Destination square of the king
+/// @returns A pair with the origin and the destination squares of the rook
+constexpr std::pair<square, square> castling_rook_squares(const square king_to) {
+    switch (king_to) {
+    case square::g1:
+        return {square::h1, square::f1};
+    case square::c1:
+        return {square::a1, square::d1};
+    case square::g8:
+        return {square::h8, square::f8};
+    case square::c8:
+        return {square::a8, square::d8};
+    default:
+        throw std::runtime_error("Castling to invalid square!\n");
+    }
+}
+
+board_state& position::push_state() {
+    // Long games of reversible moves can fill the history. Repetition detection never looks back
+    // further than the halfmove clock, and the search never unmakes more than max_ply moves, so
+    // only that many states are kept and the oldest ones are dropped
+    if (m_history_size == m_history.size()) {
+        constexpr usize kept_states = constants::max_ply + std::numeric_limits<u8>::max();
+        static_assert(kept_states < constants::max_game_ply);
+
+        std::move(m_history.end() - kept_states, m_history.end(), m_history.begin());
+        m_history_size = kept_states;
+    }
+
+    board_state& state = m_history[m_history_size++];
+
+    state.key                = m_key;
+    state.checkers_bb        = m_checkers_bb;
+    state.castling           = m_castling;
+    state.ep_sq              = m_ep_sq;
+    state.half_move_clock    = m_half_move_clock;
+    state.captured_piece     = piece::none;
+    state.last_move_was_null = m_last_move_was_null;
+
+    return state;
+}
+
+void position::pop_state() {
+    assert(m_history_size > 0);
+
+    const board_state& state = m_history[--m_history_size];
+
+    m_key                = state.key;
+    m_checkers_bb        = state.checkers_bb;
+    m_castling           = state.castling;
+    m_ep_sq              = state.ep_sq;
+    m_half_move_clock    = state.half_move_clock;
+    m_last_move_was_null = state.last_move_was_null;
+}
+
 void position::make_move(const moves::move move) {
-    ++m_half_move_clock;
+    board_state& state = push_state();
 
-    if constexpr (SaveHashHistory)
-        m_hash_history.push_back(m_key);
+    ++m_half_move_clock;
 
     const square    from         = move.from();
     const square    to           = move.to();
     const piece     moving_piece = piece_on(from);
     const direction offset       = m_stm == color::white ? direction::north : direction::south;
 
+    const piece placed_piece = move.is_promotion() ? move.get_promoted_piece(m_stm) : moving_piece;
+
+    // The accumulator of the parent position is kept in the stack, so unmaking the move only has
+    // to drop the updated copy
+    if (m_accumulators != nullptr)
+        m_accumulators->push();
+
     if (move.is_capture()) {
         const square target_square = move.is_en_passant() ? m_ep_sq - offset : to;
-        remove_piece(piece_on(target_square), target_square);
+        state.captured_piece       = piece_on(target_square);
+        remove_piece(state.captured_piece, target_square);
         m_half_move_clock = 0;
+
+        if (m_accumulators != nullptr)
+            m_accumulators->remove_piece(state.captured_piece, target_square);
     }
 
     remove_piece(moving_piece, from);
-    set_piece(move.is_promotion() ? move.get_promoted_piece(m_stm) : moving_piece, to);
+    set_piece(placed_piece, to);
+
+    if (m_accumulators != nullptr) {
+        m_accumulators->remove_piece(moving_piece, from);
+        m_accumulators->add_piece(placed_piece, to);
+    }
 
     m_key ^= utils::zobrist::get_side_key(m_stm);
     m_key ^= utils::zobrist::get_en_passant_key(m_ep_sq);
@@ -212,21 +321,12 @@ void position::make_move(const moves::move move) {
         m_ep_sq = square::none;
 
     if (move.is_castling()) {
-        switch (to) {
-        case square::g1:
-            move_piece(piece_on(square::h1), square::h1, square::f1);
-            break;
-        case square::c1:
-            move_piece(piece_on(square::a1), square::a1, square::d1);
-            break;
-        case square::g8:
-            move_piece(piece_on(square::h8), square::h8, square::f8);
-            break;
-        case square::c8:
-            move_piece(piece_on(square::a8), square::a8, square::d8);
-            break;
-        default:
-            throw std::runtime_error("Castling to invalid square!\n");
+        const auto [rook_from, rook_to] = castling_rook_squares(to);
+        move_piece(piece_on(rook_from), rook_from, rook_to);
+
+        if (m_accumulators != nullptr) {
+            m_accumulators->remove_piece(piece_on(rook_to), rook_from);
+            m_accumulators->add_piece(piece_on(rook_to), rook_to);
         }
     }
 
@@ -252,26 +352,102 @@ void position::make_move(const moves::move move) {
     m_last_move_was_null = false;
 }
 
-template void position::make_move<true>(moves::move move);
-template void position::make_move<false>(moves::move move);
+void position::unmake_move(const moves::move move) {
+    m_stm = ~m_stm;
+    m_full_move_number -= m_stm == color::black;
+
+    const square    from        = move.from();
+    const square    to          = move.to();
+    const direction offset      = m_stm == color::white ? direction::north : direction::south;
+    const piece     pawn        = m_stm == color::white ? piece::w_pawn : piece::b_pawn;
+    const piece     moved_piece = move.is_promotion() ? pawn : piece_on(to);
+
+    if (move.is_castling()) {
+        const auto [rook_from, rook_to] = castling_rook_squares(to);
+        move_piece(piece_on(rook_to), rook_to, rook_from);
+    }
+
+    remove_piece(piece_on(to), to);
+    set_piece(moved_piece, from);
+
+    if (move.is_capture()) {
+        const board_state& state = m_history[m_history_size - 1];
+        set_piece(state.captured_piece, move.is_en_passant() ? state.ep_sq - offset : to);
+    }
+
+    // Restoring the state after putting the pieces back also restores the key
+    pop_state();
+
+    if (m_accumulators != nullptr)
+        m_accumulators->pop();
+}
+
+zobrist_key position::key_after(const moves::move move) const {
+    const square    from         = move.from();
+    const square    to           = move.to();
+    const piece     moving_piece = piece_on(from);
+    const direction offset       = m_stm == color::white ? direction::north : direction::south;
+
+    const piece placed_piece = move.is_promotion() ? move.get_promoted_piece(m_stm) : moving_piece;
+
+    zobrist_key key = m_key;
+
+    if (move.is_capture()) {
+        const square target_square = move.is_en_passant() ? m_ep_sq - offset : to;
+        key ^= utils::zobrist::get_piece_key(piece_on(target_square), target_square);
+    }
+
+    key ^= utils::zobrist::get_piece_key(moving_piece, from);
+    key ^= utils::zobrist::get_piece_key(placed_piece, to);
+
+    key ^= utils::zobrist::get_en_passant_key(m_ep_sq);
+
+    if (move.is_double_push())
+        key ^= utils::zobrist::get_en_passant_key(to - offset);
+
+    if (move.is_castling()) {
+        const auto [rook_from, rook_to] = castling_rook_squares(to);
+        const piece rook                = piece_on(rook_from);
+
+        key ^= utils::zobrist::get_piece_key(rook, rook_from);
+        key ^= utils::zobrist::get_piece_key(rook, rook_to);
+    }
+
+    const castling_rights castling = m_castling
+                                   & castling_rights_update[std::to_underlying(from)]
+                                   & castling_rights_update[std::to_underlying(to)];
+
+    if (castling != m_castling) {
+        key ^= utils::zobrist::get_castling_key(m_castling);
+        key ^= utils::zobrist::get_castling_key(castling);
+    }
+
+    return key ^ utils::zobrist::get_side_key(m_stm) ^ utils::zobrist::get_side_key(~m_stm);
+}
 
 void position::make_null_move() {
-    ++m_half_move_clock;
+    push_state();
 
-    m_hash_history.push_back(m_key);
+    ++m_half_move_clock;
 
     m_key ^= utils::zobrist::get_side_key(m_stm);
     m_key ^= utils::zobrist::get_en_passant_key(m_ep_sq);
 
-    m_stm = ~m_stm;
+    m_ep_sq = square::none;
+    m_stm   = ~m_stm;
     m_key ^= utils::zobrist::get_side_key(m_stm);
 
     m_checkers_bb        = attacks_to_king(king_square(m_stm), m_stm);
     m_last_move_was_null = true;
 }
 
+void position::unmake_null_move() {
+    m_stm = ~m_stm;
+    pop_state();
+}
+
 void position::reset_to_start_pos() {
-    m_hash_history.clear();
+    clear_history();
     m_pieces.fill(piece::none);
 
     m_checkers_bb      = bitboards::util::empty_bb;
@@ -320,6 +496,21 @@ void position::reset_to_start_pos() {
 
     m_pieces[std::to_underlying(square::e1)] = piece::w_king;
     m_pieces[std::to_underlying(square::e8)] = piece::b_king;
+
+    m_pawn_key   = 0ULL;
+    m_psqt_score = eval::packed_score();
+    m_game_phase = 0;
+
+    for (u8 sq = 0; sq < constants::num_squares; ++sq) {
+        if (const piece p = m_pieces[sq]; p != piece::none) {
+            if (pieces::piece_to_piece_type(p) == piece_type::pawn)
+                m_pawn_key ^= utils::zobrist::get_piece_key(p, static_cast<square>(sq));
+
+            m_psqt_score += eval::psqt[std::to_underlying(p)][sq];
+            m_game_phase +=
+                eval::game_phase_increments[std::to_underlying(pieces::piece_to_piece_type(p))];
+        }
+    }
 }
 
 template <color C>
@@ -406,19 +597,146 @@ bool position::is_valid() const {
 
 bool position::was_legal() const { return !is_square_attacked_by(king_square(~m_stm), m_stm); }
 
+bool position::is_legal(const moves::move move) const {
+    const square from      = move.from();
+    const square to        = move.to();
+    const square king_sq   = king_square(m_stm);
+    const auto&  occupied  = occupancies(color::white) | occupancies(color::black);
+    const auto&  opponents = occupancies(~m_stm);
+
+    // The move generator already checks that the king does not castle out of or through check
+    if (move.is_castling())
+        return true;
+
+    // The king can't move to an attacked square. It is removed from the occupancy so that sliders
+    // attacking it keep attacking the squares behind it
+    if (from == king_sq) {
+        auto occupied_without_king = occupied;
+        bitboards::bitboard::clear_bit(occupied_without_king, from);
+
+        return (attackers_to(to, occupied_without_king) & opponents).empty();
+    }
+
+    // En passant removes two pieces from the same rank, so the resulting position is fully checked
+    if (move.is_en_passant()) {
+        const direction offset = m_stm == color::white ? direction::north : direction::south;
+        auto            occupied_after_move = occupied;
+
+        bitboards::bitboard::clear_bit(occupied_after_move, from);
+        bitboards::bitboard::clear_bit(occupied_after_move, to - offset);
+        bitboards::bitboard::set_bit(occupied_after_move, to);
+
+        return (attackers_to(king_sq, occupied_after_move) & opponents & occupied_after_move)
+            .empty();
+    }
+
+    // Only the king can move in double check, and in single check the move must either capture
+    // the checker or block the check
+    if (!m_checkers_bb.empty()) {
+        if (m_checkers_bb.bit_count() > 1)
+            return false;
+
+        const auto checker_sq = static_cast<square>(m_checkers_bb.get_lsb());
+
+        if (!bitboards::bitboard::is_bit_set(
+                bitboards::attacks::get_between(king_sq, checker_sq) | m_checkers_bb, to))
+            return false;
+    }
+
+    // Pieces that are not aligned with the king can't be pinned
+    const auto& pin_line = bitboards::attacks::get_line(king_sq, from);
+
+    if (pin_line.empty() || bitboards::bitboard::is_bit_set(pin_line, to))
+        return true;
+
+    // The piece leaves the line it shares with the king, so make sure no slider is behind it
+    auto occupied_after_move = occupied;
+    bitboards::bitboard::clear_bit(occupied_after_move, from);
+
+    const auto& queens           = piece_type_bb(piece_type::queen);
+    const auto& diagonal_sliders = (piece_type_bb(piece_type::bishop) | queens) & opponents;
+    const auto& straight_sliders = (piece_type_bb(piece_type::rook) | queens) & opponents;
+
+    const auto& attackers =
+        (bitboards::attacks::get_bishop_attacks(king_sq, occupied_after_move) & diagonal_sliders)
+        | (bitboards::attacks::get_rook_attacks(king_sq, occupied_after_move) & straight_sliders);
+
+    return (attackers & pin_line).empty();
+}
+
+bool position::is_pseudo_legal(const moves::move move) const {
+    using flag = moves::move::move_flag;
+
+    const square from         = move.from();
+    const square to           = move.to();
+    const piece  moving_piece = piece_on(from);
+
+    if (move.flag() == flag::no_move || move.flag() == flag::null_move
+        || moving_piece == piece::none || pieces::piece_color(moving_piece) != m_stm
+        || bitboards::bitboard::is_bit_set(occupancies(m_stm), to))
+        return false;
+
+    const piece_type          pt       = pieces::piece_to_piece_type(moving_piece);
+    const bitboards::bitboard occupied = occupancies(color::white) | occupancies(color::black);
+
+    if (move.is_castling()) {
+        if (pt != piece_type::king || !m_checkers_bb.empty())
+            return false;
+
+        if (m_stm == color::white)
+            return from == square::e1
+                && ((to == square::g1 && can_castle_king_side<color::white>())
+                    || (to == square::c1 && can_castle_queen_side<color::white>()));
+
+        return from == square::e8
+            && ((to == square::g8 && can_castle_king_side<color::black>())
+                || (to == square::c8 && can_castle_queen_side<color::black>()));
+    }
+
+    if (move.is_en_passant())
+        return pt == piece_type::pawn && to == m_ep_sq
+            && bitboards::bitboard::is_bit_set(bitboards::attacks::get_pawn_attacks(from, m_stm),
+                                               to);
+
+    // Captures must land on an enemy piece, and the rest of moves on an empty square
+    if (move.is_capture() != bitboards::bitboard::is_bit_set(occupancies(~m_stm), to))
+        return false;
+
+    if (pt != piece_type::pawn)
+        return !move.is_promotion() && !move.is_double_push()
+            && bitboards::bitboard::is_bit_set(
+                   bitboards::attacks::get_attacks_by_piece_type(pt, from, occupied), to);
+
+    const rank to_rank = rank_of(to);
+
+    if (move.is_promotion() != (to_rank == rank::rank_1 || to_rank == rank::rank_8))
+        return false;
+
+    if (move.is_capture())
+        return bitboards::bitboard::is_bit_set(bitboards::attacks::get_pawn_attacks(from, m_stm),
+                                               to);
+
+    const direction offset = m_stm == color::white ? direction::north : direction::south;
+
+    if (move.is_double_push())
+        return rank_of(from) == (m_stm == color::white ? rank::rank_2 : rank::rank_7)
+            && to == from + offset * 2
+            && !bitboards::bitboard::is_bit_set(occupied, from + offset);
+
+    return to == from + offset;
+}
+
 bool position::has_repeated() const {
-    const usize history_size      = m_hash_history.size();
-    const auto  repetition_offset = std::min<usize>(m_half_move_clock, history_size - 1);
+    const auto repetition_offset = std::min<usize>(m_half_move_clock, m_history_size);
 
     for (usize i = 4; i <= repetition_offset; i += 2) {
-        if (m_key == m_hash_history[history_size - i])
+        if (m_key == m_history[m_history_size - i].key)
             return true;
     }
 
     return false;
 }
 
-
 std::string position::to_fen() const {
     std::string fen;
 
@@ -455,38 +773,39 @@ std::string position::to_fen() const {
 }
 
 void print_board(const position& pos) {
-    std::cout << std::format("\n+---+---+---+---+---+---+---+---+") << std::endl;
+    utils::io::print_line("\n+---+---+---+---+---+---+---+---+");
 
     for (int rank = constants::num_ranks - 1; rank >= 0; --rank) {
+        std::string row;
+
         for (u8 file = 0; file < constants::num_files; ++file) {
             const square sq            = square_of(file, rank);
             const piece  current_piece = pos.piece_on(sq);
 
-            std::cout << std::format(
+            row += std::format(
                 "| {}", current_piece == piece::none ? ' ' : pieces::piece_to_char(current_piece));
 
             if (file != constants::num_files - 1)
-                std::cout << std::format(" ");
+                row += ' ';
         }
-        std::cout << std::format(" | {}\n+---+---+---+---+---+---+---+---+", rank + 1) << std::endl;
+        utils::io::print_line(
+            std::format("{} | {}\n+---+---+---+---+---+---+---+---+", row, rank + 1));
     }
 
-    std::cout << std::format("  A   B   C   D   E   F   G   H\n") << std::endl;
-    std::cout << std::format("Side to move    : {}",
-                             pos.side_to_move() == color::white ? "white" : "black")
-              << std::endl;
+    utils::io::print_line("  A   B   C   D   E   F   G   H\n");
+    utils::io::print_line(std::format("Side to move    : {}",
+                                      pos.side_to_move() == color::white ? "white" : "black"));
 
     const square en_passant = pos.ep_square();
 
-    std::cout << std::format(
+    utils::io::print_line(std::format(
         "En passant      : {}",
-        en_passant != square::none ? util::sq_to_coords[std::to_underlying(en_passant)] : "-")
-              << std::endl;
-    std::cout << std::format("Castling rights : {}", pos.castling().to_string()) << std::endl;
-    std::cout << std::format("Halfmove clock  : {}", pos.fifty_move_rule()) << std::endl;
-    std::cout << std::format("Fullmove number : {}", pos.full_moves()) << std::endl;
-    std::cout << std::format("FEN             : {}", pos.to_fen()) << std::endl;
-    std::cout << std::format("Hash            : 0x{:016X}\n", pos.key()) << std::endl;
+        en_passant != square::none ? util::sq_to_coords[std::to_underlying(en_passant)] : "-"));
+    utils::io::print_line(std::format("Castling rights : {}", pos.castling().to_string()));
+    utils::io::print_line(std::format("Halfmove clock  : {}", pos.fifty_move_rule()));
+    utils::io::print_line(std::format("Fullmove number : {}", pos.full_moves()));
+    utils::io::print_line(std::format("FEN             : {}", pos.to_fen()));
+    utils::io::print_line(std::format("Hash            : 0x{:016X}\n", pos.key()));
 }
 
 } // namespace board
\ No newline at end of file
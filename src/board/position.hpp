@@ -2,12 +2,16 @@
 
 #include <array>
 #include <string>
-#include <vector>
 
 #include "bitboard/bitboard.hpp"
 
+#include "../eval/packed_score.hpp"
 #include "../moves/move.hpp"
 
+namespace eval::nnue {
+class accumulator_stack;
+}
+
 namespace board {
 
 class castling_rights {
@@ -118,6 +122,18 @@ class castling_rights {
         castling_flag m_flags;
 };
 
+/// @brief Irreversible information of a position, saved before making a move so that it can be
+/// restored when unmaking it
+struct board_state {
+        zobrist_key         key;
+        bitboards::bitboard checkers_bb;
+        castling_rights     castling;
+        square              ep_sq;
+        u8                  half_move_clock;
+        piece               captured_piece;
+        bool                last_move_was_null;
+};
+
 class position {
     public:
         position() :
@@ -127,19 +143,11 @@ class position {
             m_stm(color::white),
             m_ep_sq(square::none),
             m_half_move_clock(0) {
-            m_hash_history.reserve(constants::max_game_ply);
             m_pieces.fill(piece::none);
         }
 
         explicit position(const std::string& fen);
 
-        /// @note Only used during perft to avoid copying the hash history vector recursively
-        static position copy_without_hash_history(const position& other) {
-            position copy = other;
-            copy.m_hash_history.clear();
-            return copy;
-        }
-
         [[nodiscard]] bitboards::bitboard checkers() const { return m_checkers_bb; }
         [[nodiscard]] color               side_to_move() const { return m_stm; }
         [[nodiscard]] square              ep_square() const { return m_ep_sq; }
@@ -149,6 +157,30 @@ class position {
         [[nodiscard]] zobrist_key         key() const { return m_key; }
         [[nodiscard]] bool last_move_was_null() const { return m_last_move_was_null; }
 
+        /// @brief Zobrist key of the pawns of both sides, used to cache the pawn structure
+        /// evaluation
+        /// @note Updated incrementally every time a pawn is set or removed
+        [[nodiscard]] zobrist_key pawn_key() const { return m_pawn_key; }
+
+        /// @brief Material and piece-square table score, from white's point of view
+        /// @note Updated incrementally every time a piece is set or removed
+        [[nodiscard]] eval::packed_score psqt_score() const { return m_psqt_score; }
+
+        /// @brief Game phase of the position, not clamped to the maximum game phase
+        [[nodiscard]] int game_phase() const { return m_game_phase; }
+
+        /// @brief Accumulators of the network, updated incrementally when making and unmaking
+        /// moves (nullptr if the position doesn't have any attached)
+        [[nodiscard]] const eval::nnue::accumulator_stack* accumulators() const {
+            return m_accumulators;
+        }
+
+        /// @brief Attaches a stack of network accumulators to the position, refreshing it
+        /// @param accumulators Stack to update incrementally, or nullptr to detach the current one
+        /// @note Copies of the position share the attached stack, so moves must only be made on one
+        /// of them
+        void set_accumulators(eval::nnue::accumulator_stack* accumulators);
+
         [[nodiscard]] piece piece_on(const square sq) const {
             return m_pieces[std::to_underlying(sq)];
         }
@@ -172,6 +204,13 @@ class position {
 
         [[nodiscard]] bitboards::bitboard attacks_to_king(square kingSquare, color c) const;
 
+        /// @brief Gets the pieces of both sides attacking a square
+        /// @param sq Attacked square
+        /// @param occupied Occupancy used to compute the sliding attacks
+        /// @returns The bitboard of attackers, which may include pieces not present in occupied
+        [[nodiscard]] bitboards::bitboard attackers_to(square                     sq,
+                                                       const bitboards::bitboard& occupied) const;
+
         [[nodiscard]] square king_square(color c) const;
 
         void set_piece(piece p, square sq);
@@ -180,11 +219,29 @@ class position {
 
         void move_piece(piece p, square from, square to);
 
-        template <bool SaveHashHistory>
         void make_move(moves::move move);
 
+        /// @brief Takes back a move, restoring the position as it was before making it
+        /// @param move Move to unmake, which must be the last move made
+        void unmake_move(moves::move move);
+
         void make_null_move();
 
+        void unmake_null_move();
+
+        /// @brief Computes the zobrist key the position would have after making a move, without
+        /// making it
+        /// @param move Legal move of the current position
+        /// @returns The key after the move
+        /// @note Used to prefetch the transposition table bucket of the child position before
+        /// the move is actually made
+        [[nodiscard]] zobrist_key key_after(moves::move move) const;
+
+        /// @brief Forgets all the previously made moves, which can't be unmade afterwards
+        /// @note Positions before an irreversible move can never be repeated, so this is used to
+        /// keep the history small when playing the moves of a game
+        void clear_history() { m_history_size = 0; }
+
         void reset_to_start_pos();
 
         [[nodiscard]] bool has_no_pawns(color c) const;
@@ -195,6 +252,19 @@ class position {
 
         [[nodiscard]] bool was_legal() const;
 
+        /// @brief Checks if a pseudo-legal move leaves the own king safe, without making it
+        /// @param move Pseudo-legal move of the current position
+        /// @returns true if the move is legal
+        /// @note Unlike was_legal, the move doesn't need to be made first, which makes it cheaper
+        [[nodiscard]] bool is_legal(moves::move move) const;
+
+        /// @brief Checks if a move could have been generated in this position, ignoring whether
+        /// it leaves the king in check
+        /// @param move Move to check, possibly coming from another position (e.g. the
+        /// transposition table or the killer moves)
+        /// @returns true if the move is pseudo-legal in this position
+        [[nodiscard]] bool is_pseudo_legal(moves::move move) const;
+
         [[nodiscard]] bool has_repeated() const;
 
         [[nodiscard]] std::string to_fen() const;
@@ -216,18 +286,30 @@ class position {
         template <color C>
         [[nodiscard]] bool has_no_pawns() const;
 
-        std::vector<zobrist_key>                                    m_hash_history;
+        /// @brief Saves the irreversible information of the position in the history
+        /// @returns The saved state
+        board_state& push_state();
+
+        /// @brief Restores the irreversible information of the position from the history
+        void pop_state();
+
+        std::array<board_state, constants::max_game_ply>            m_history;
+        usize                                                       m_history_size{};
         std::array<piece, constants::num_squares>                   m_pieces;
         std::array<bitboards::bitboard, constants::num_piece_types> m_piece_bb;
         std::array<bitboards::bitboard, constants::num_colors>      m_occupied_bb;
         bitboards::bitboard                                         m_checkers_bb;
         zobrist_key                                                 m_key;
+        zobrist_key                                                 m_pawn_key{};
         u16                                                         m_full_move_number;
         color                                                       m_stm;
         square                                                      m_ep_sq;
         castling_rights                                             m_castling;
         u8                                                          m_half_move_clock;
         bool                                                        m_last_move_was_null{false};
+        eval::packed_score                                          m_psqt_score;
+        int                                                         m_game_phase{};
+        eval::nnue::accumulator_stack*                              m_accumulators{};
 };
 
 namespace util {
@@ -0,0 +1,272 @@
+#include "nnue.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+#endif
+
+#include "../board/piece.hpp"
+#include "../board/position.hpp"
+#include "../utils/cpu.hpp"
+
+namespace eval::nnue {
+
+namespace {
+
+/// @brief Size of the network file, which has no padding between the parameters
+constexpr usize network_file_size =
+    (input_size * hidden_size + hidden_size + hidden_size * 2 + 1) * sizeof(i16);
+
+std::unique_ptr<network> loaded_network;
+
+/// @brief Gets the input feature of a piece, from the point of view of one of the sides. Squares
+/// are flipped for black, so that both sides see the board the same way
+usize feature_index(const color perspective, const piece p, const square sq) {
+    const usize relative_color = board::pieces::piece_color(p) == perspective ? 0 : 1;
+    const usize relative_sq    = perspective == color::white ? std::to_underlying(sq)
+                                                             : std::to_underlying(sq) ^ 56;
+
+    return (relative_color * constants::num_piece_types
+            + std::to_underlying(board::pieces::piece_to_piece_type(p)))
+             * constants::num_squares
+         + relative_sq;
+}
+
+/// @brief SIMD kernels of the network inference. All of them are compiled into the binary and
+/// the best one supported by the CPU is picked at startup
+namespace kernels {
+
+namespace scalar {
+
+void add(i16* values, const i16* weights) {
+    for (usize i = 0; i < hidden_size; ++i)
+        values[i] += weights[i];
+}
+
+void sub(i16* values, const i16* weights) {
+    for (usize i = 0; i < hidden_size; ++i)
+        values[i] -= weights[i];
+}
+
+i32 crelu_dot(const i16* values, const i16* weights) {
+    i32 sum = 0;
+
+    for (usize i = 0; i < hidden_size; ++i)
+        sum += std::clamp<i32>(values[i], 0, qa) * weights[i];
+
+    return sum;
+}
+
+} // namespace scalar
+
+#if defined(__x86_64__) || defined(__i386__)
+
+namespace avx2 {
+
+inline constexpr usize chunk_size = sizeof(__m256i) / sizeof(i16);
+
+__attribute__((target("avx2"))) void add(i16* values, const i16* weights) {
+    for (usize i = 0; i < hidden_size; i += chunk_size) {
+        const auto v = _mm256_load_si256(reinterpret_cast<const __m256i*>(values + i));
+        const auto w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(values + i), _mm256_add_epi16(v, w));
+    }
+}
+
+__attribute__((target("avx2"))) void sub(i16* values, const i16* weights) {
+    for (usize i = 0; i < hidden_size; i += chunk_size) {
+        const auto v = _mm256_load_si256(reinterpret_cast<const __m256i*>(values + i));
+        const auto w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(values + i), _mm256_sub_epi16(v, w));
+    }
+}
+
+__attribute__((target("avx2"))) i32 crelu_dot(const i16* values, const i16* weights) {
+    const auto zero = _mm256_setzero_si256();
+    const auto max  = _mm256_set1_epi16(qa);
+    auto       sum  = _mm256_setzero_si256();
+
+    for (usize i = 0; i < hidden_size; i += chunk_size) {
+        const auto v = _mm256_min_epi16(
+            _mm256_max_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(values + i)), zero),
+            max);
+        const auto w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+
+        // Clipped values fit in 8 bits, so the pairwise products never overflow the 32-bit lanes
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, w));
+    }
+
+    const auto sum_128 =
+        _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    const auto sum_64 = _mm_add_epi32(sum_128, _mm_unpackhi_epi64(sum_128, sum_128));
+    const auto sum_32 = _mm_add_epi32(sum_64, _mm_shuffle_epi32(sum_64, 1));
+
+    return _mm_cvtsi128_si32(sum_32);
+}
+
+} // namespace avx2
+
+namespace avx512 {
+
+inline constexpr usize chunk_size = sizeof(__m512i) / sizeof(i16);
+
+__attribute__((target("avx512f,avx512bw"))) void add(i16* values, const i16* weights) {
+    for (usize i = 0; i < hidden_size; i += chunk_size) {
+        const auto v = _mm512_load_si512(values + i);
+        const auto w = _mm512_load_si512(weights + i);
+        _mm512_store_si512(values + i, _mm512_add_epi16(v, w));
+    }
+}
+
+__attribute__((target("avx512f,avx512bw"))) void sub(i16* values, const i16* weights) {
+    for (usize i = 0; i < hidden_size; i += chunk_size) {
+        const auto v = _mm512_load_si512(values + i);
+        const auto w = _mm512_load_si512(weights + i);
+        _mm512_store_si512(values + i, _mm512_sub_epi16(v, w));
+    }
+}
+
+__attribute__((target("avx512f,avx512bw"))) i32 crelu_dot(const i16* values, const i16* weights) {
+    const auto zero = _mm512_setzero_si512();
+    const auto max  = _mm512_set1_epi16(qa);
+    auto       sum  = _mm512_setzero_si512();
+
+    for (usize i = 0; i < hidden_size; i += chunk_size) {
+        const auto v =
+            _mm512_min_epi16(_mm512_max_epi16(_mm512_load_si512(values + i), zero), max);
+        const auto w = _mm512_load_si512(weights + i);
+        sum          = _mm512_add_epi32(sum, _mm512_madd_epi16(v, w));
+    }
+
+    return _mm512_reduce_add_epi32(sum);
+}
+
+} // namespace avx512
+
+#endif
+
+struct kernel_set {
+        void (*add)(i16*, const i16*);
+        void (*sub)(i16*, const i16*);
+        i32 (*crelu_dot)(const i16*, const i16*);
+};
+
+kernel_set select() {
+#if defined(__x86_64__) || defined(__i386__)
+    const auto& features = utils::cpu::get_features();
+
+    if (features.avx512bw)
+        return {avx512::add, avx512::sub, avx512::crelu_dot};
+
+    if (features.avx2)
+        return {avx2::add, avx2::sub, avx2::crelu_dot};
+#endif
+
+    return {scalar::add, scalar::sub, scalar::crelu_dot};
+}
+
+const kernel_set active = select();
+
+void add(i16* values, const i16* weights) { active.add(values, weights); }
+
+void sub(i16* values, const i16* weights) { active.sub(values, weights); }
+
+i32 crelu_dot(const i16* values, const i16* weights) { return active.crelu_dot(values, weights); }
+
+} // namespace kernels
+
+const i16* feature_weights(const color perspective, const piece p, const square sq) {
+    return loaded_network->feature_weights.data()
+         + feature_index(perspective, p, sq) * hidden_size;
+}
+
+void refresh(accumulator& acc, const board::position& pos) {
+    for (const color perspective : {color::white, color::black}) {
+        auto& values = acc.values[std::to_underlying(perspective)];
+        values       = loaded_network->feature_bias;
+
+        for (u8 i = 0; i < constants::num_squares; ++i) {
+            const auto sq = static_cast<square>(i);
+
+            if (const piece p = pos.piece_on(sq); p != piece::none)
+                kernels::add(values.data(), feature_weights(perspective, p, sq));
+        }
+    }
+}
+
+score evaluate(const accumulator& acc, const color stm) {
+    const auto& us   = acc.values[std::to_underlying(stm)];
+    const auto& them = acc.values[std::to_underlying(~stm)];
+
+    const i32 output = kernels::crelu_dot(us.data(), loaded_network->output_weights.data())
+                     + kernels::crelu_dot(them.data(),
+                                          loaded_network->output_weights.data() + hidden_size);
+
+    const score eval = (output + loaded_network->output_bias) * eval_scale / (qa * qb);
+
+    // Keep the network output away from mate scores
+    return std::clamp(eval, -constants::score_win + 1, constants::score_win - 1);
+}
+
+} // namespace
+
+bool load_network(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+    if (!file || static_cast<usize>(file.tellg()) != network_file_size)
+        return false;
+
+    auto net = std::make_unique<network>();
+
+    file.seekg(0);
+
+    if (!file.read(reinterpret_cast<char*>(net.get()),
+                   static_cast<std::streamsize>(network_file_size)))
+        return false;
+
+    loaded_network = std::move(net);
+
+    return true;
+}
+
+void unload_network() { loaded_network.reset(); }
+
+bool network_loaded() { return loaded_network != nullptr; }
+
+void accumulator_stack::reset(const board::position& pos) {
+    m_size = 1;
+    refresh(m_accumulators[0], pos);
+}
+
+void accumulator_stack::add_piece(const piece p, const square sq) {
+    auto& acc = m_accumulators[m_size - 1];
+
+    kernels::add(acc.values[std::to_underlying(color::white)].data(),
+                 feature_weights(color::white, p, sq));
+    kernels::add(acc.values[std::to_underlying(color::black)].data(),
+                 feature_weights(color::black, p, sq));
+}
+
+void accumulator_stack::remove_piece(const piece p, const square sq) {
+    auto& acc = m_accumulators[m_size - 1];
+
+    kernels::sub(acc.values[std::to_underlying(color::white)].data(),
+                 feature_weights(color::white, p, sq));
+    kernels::sub(acc.values[std::to_underlying(color::black)].data(),
+                 feature_weights(color::black, p, sq));
+}
+
+score evaluate(const board::position& pos) {
+    if (const auto* accumulators = pos.accumulators())
+        return evaluate(accumulators->current(), pos.side_to_move());
+
+    accumulator acc;
+    refresh(acc, pos);
+
+    return evaluate(acc, pos.side_to_move());
+}
+
+} // namespace eval::nnue
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+#include "../chess.hpp"
+
+namespace board {
+class position;
+}
+
+namespace eval::nnue {
+
+/// @brief Network architecture: (768 -> hidden_size)x2 -> 1, with one accumulator per perspective
+inline constexpr usize input_size  = constants::num_pieces * constants::num_squares;
+inline constexpr usize hidden_size = 256;
+
+/// @brief Quantization factors of the accumulator and the output layer
+inline constexpr i32 qa = 255;
+inline constexpr i32 qb = 64;
+
+/// @brief Scale applied to the network output to convert it to centipawns
+inline constexpr i32 eval_scale = 400;
+
+/// @brief Quantized network parameters, laid out exactly as they are stored in the network file
+/// (little-endian i16 values)
+struct alignas(64) network {
+        std::array<i16, input_size * hidden_size> feature_weights;
+        std::array<i16, hidden_size>              feature_bias;
+        std::array<i16, hidden_size * 2>          output_weights;
+        i16                                       output_bias;
+};
+
+/// @brief Hidden layer values of a position, from the point of view of both sides
+struct alignas(64) accumulator {
+        std::array<std::array<i16, hidden_size>, constants::num_colors> values;
+};
+
+/// @brief Loads the network parameters from a file
+/// @param path Path to the network file
+/// @returns true if the network was loaded, false if the file can't be read or its size doesn't
+/// match the network architecture
+/// @note On failure, the previously loaded network (if any) is kept
+bool load_network(const std::string& path);
+
+/// @brief Unloads the network, so that the hand-crafted evaluation is used again
+void unload_network();
+
+[[nodiscard]] bool network_loaded();
+
+/// @class accumulator_stack
+/// @brief Accumulators of the positions of the current search line, one per ply. Making a move
+/// copies the accumulator of the parent and applies the feature changes to it, so unmaking a move
+/// only has to drop the top one
+class accumulator_stack {
+    public:
+        /// @brief Clears the stack and computes the accumulator of a position from scratch
+        void reset(const board::position& pos);
+
+        void push() {
+            m_accumulators[m_size] = m_accumulators[m_size - 1];
+            ++m_size;
+        }
+
+        void pop() { --m_size; }
+
+        [[nodiscard]] const accumulator& current() const { return m_accumulators[m_size - 1]; }
+
+        void add_piece(piece p, square sq);
+
+        void remove_piece(piece p, square sq);
+
+    private:
+        std::array<accumulator, constants::max_ply + 1> m_accumulators;
+        usize                                           m_size{1};
+};
+
+/// @brief Evaluates a position with the network
+/// @param pos Position to evaluate. Its attached accumulator stack is used if present, otherwise
+/// the accumulator is computed from scratch
+/// @returns The score of the position, from the side to move's point of view
+/// @note The network must be loaded
+[[nodiscard]] score evaluate(const board::position& pos);
+
+} // namespace eval::nnue
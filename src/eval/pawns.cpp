@@ -0,0 +1,114 @@
+#include "pawns.hpp"
+
+#include "psqt.hpp"
+
+namespace eval::pawns {
+
+namespace bb = board::bitboards;
+
+/// @brief Evaluation terms
+namespace terms {
+
+/// @brief Passed pawn bonus, indexed by relative rank
+inline constexpr std::array passed_pawn = {S(0, 0),   S(-4, 12),  S(-8, 18),  S(-2, 38),
+                                           S(18, 64), S(42, 112), S(86, 168), S(0, 0)};
+
+inline constexpr packed_score isolated_pawn = S(-11, -13);
+inline constexpr packed_score doubled_pawn  = S(-9, -22);
+inline constexpr packed_score backward_pawn = S(-7, -9);
+
+} // namespace terms
+
+namespace {
+
+/// @brief Fills the squares in front of the given ones (from the point of view of a side)
+template <color C>
+constexpr bb::bitboard forward_fill(bb::bitboard bitboard) {
+    if constexpr (C == color::white) {
+        bitboard |= bitboard << 8;
+        bitboard |= bitboard << 16;
+        bitboard |= bitboard << 32;
+    }
+    else {
+        bitboard |= bitboard >> 8;
+        bitboard |= bitboard >> 16;
+        bitboard |= bitboard >> 32;
+    }
+
+    return bitboard;
+}
+
+template <color C>
+constexpr bb::bitboard forward(const bb::bitboard& bitboard) {
+    if constexpr (C == color::white)
+        return bb::shift<direction::north>(bitboard);
+    else
+        return bb::shift<direction::south>(bitboard);
+}
+
+constexpr bb::bitboard adjacent_files(const bb::bitboard& bitboard) {
+    return bb::shift<direction::east>(bitboard) | bb::shift<direction::west>(bitboard);
+}
+
+template <color C>
+packed_score evaluate(const board::position& pos) {
+    constexpr color us   = C;
+    constexpr color them = ~us;
+
+    const auto& pawns       = pos.piece_type_bb(piece_type::pawn);
+    const auto& our_pawns   = pawns & pos.occupancies(us);
+    const auto& their_pawns = pawns & pos.occupancies(them);
+
+    // Squares in front of the enemy pawns (from their point of view), and the squares they may
+    // attack by advancing
+    const auto& their_front_spans  = forward_fill<them>(forward<them>(their_pawns));
+    const auto& their_attack_spans = adjacent_files(their_front_spans);
+
+    // Files with our pawns, and the squares our pawns can defend by advancing
+    const auto& our_files        = forward_fill<us>(our_pawns) | forward_fill<them>(our_pawns);
+    const auto& our_attack_spans = forward_fill<us>(adjacent_files(our_pawns));
+
+    const auto& their_pawn_attacks = adjacent_files(forward<them>(their_pawns));
+
+    const auto& passed   = our_pawns & ~(their_front_spans | their_attack_spans);
+    const auto& isolated = our_pawns & ~adjacent_files(our_files);
+    const auto& doubled  = our_pawns & forward_fill<us>(forward<us>(our_pawns));
+
+    // Pawns that can't be defended by other pawns and can't advance safely either
+    const auto& backward =
+        our_pawns & ~isolated & ~our_attack_spans & forward<them>(their_pawn_attacks);
+
+    packed_score score = terms::isolated_pawn * isolated.bit_count()
+                       + terms::doubled_pawn * doubled.bit_count()
+                       + terms::backward_pawn * backward.bit_count();
+
+    for (auto remaining = passed; !remaining.empty();) {
+        const auto sq            = static_cast<square>(remaining.pop_lsb());
+        const auto relative_rank = us == color::white ? std::to_underlying(rank_of(sq))
+                                                      : 7 - std::to_underlying(rank_of(sq));
+
+        score += terms::passed_pawn[relative_rank];
+    }
+
+    return score;
+}
+
+} // namespace
+
+packed_score evaluate(const board::position& pos, pawn_table* table) {
+    if (table == nullptr)
+        return evaluate<color::white>(pos) - evaluate<color::black>(pos);
+
+    // Positions without pawns have a zero pawn key and a zero score, so the empty entries are
+    // already valid for them
+    auto& entry = table->entry(pos.pawn_key());
+
+    if (entry.key != pos.pawn_key()) {
+        entry.key   = pos.pawn_key();
+        entry.score = evaluate<color::white>(pos) - evaluate<color::black>(pos);
+    }
+
+    return entry.score;
+}
+
+} // namespace eval::pawns
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "packed_score.hpp"
+
+#include "../board/position.hpp"
+
+namespace eval::pawns {
+
+struct pawn_entry {
+        zobrist_key  key;
+        packed_score score;
+};
+
+/// @class pawn_table
+/// @brief Cache of the pawn structure evaluation, indexed by the pawn key of the positions. Pawn
+/// structures repeat a lot across the search tree, so most evaluations are just a lookup
+/// @note Each search thread owns its own table, so it doesn't need any synchronization
+class pawn_table {
+    public:
+        static constexpr usize num_entries = 16384;
+
+        pawn_table() :
+            m_entries(num_entries) {}
+
+        [[nodiscard]] pawn_entry& entry(const zobrist_key key) {
+            return m_entries[key & (num_entries - 1)];
+        }
+
+    private:
+        std::vector<pawn_entry> m_entries;
+};
+
+/// @brief Evaluates the pawn structure: passed, isolated, doubled and backward pawns
+/// @param pos Position to evaluate
+/// @param table Table to look the score up in and store it to, or nullptr to always compute it
+/// @returns The score of the pawn structure, from white's point of view
+[[nodiscard]] packed_score evaluate(const board::position& pos, pawn_table* table);
+
+} // namespace eval::pawns
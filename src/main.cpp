@@ -3,16 +3,12 @@
 #include "search/bench.hpp"
 #include "uci/uci.hpp"
 
-#include "board/bitboard/attacks.hpp"
-
 int main(const int argc, const char *argv[]) {
-    board::bitboards::attacks::init();
-
     if (argc > 1 && !strcmp(argv[1], "bench")) {
         constexpr int bench_depth = 11;
 
-        search::searcher searcher;
-        search::bench::run(searcher, bench_depth);
+        search::thread_pool threads;
+        search::bench::run(threads, bench_depth);
 
         return 0;
     }
@@ -24,8 +24,63 @@ constexpr bb::bitboard double_pawn_push(const bb::bitboard& pawns, const bb::bit
              & bb::util::rank_5_bb;
 }
 
+/// @brief Squares the pieces of the side to move can go to without leaving their king in check,
+/// computed once per position so that only legal moves are generated
+struct move_restrictions {
+        /// @brief Squares that capture or block the checker when in check (all of them otherwise)
+        bb::bitboard check_mask;
+
+        /// @brief Pieces pinned to their king, which can only move along the pin line
+        bb::bitboard pinned;
+
+        square king_sq;
+
+        [[nodiscard]] bb::bitboard allowed(const square from) const {
+            return bb::bitboard::is_bit_set(pinned, from)
+                     ? check_mask & bb::attacks::get_line(king_sq, from)
+                     : check_mask;
+        }
+};
+
+template <color SideToMove>
+move_restrictions get_move_restrictions(const board::position& pos) {
+    constexpr color us   = SideToMove;
+    constexpr color them = ~us;
+
+    const square king_sq  = pos.king_square(us);
+    const auto&  occupied = pos.occupancies(us) | pos.occupancies(them);
+    const auto&  queens   = pos.piece_type_bb(piece_type::queen);
+
+    move_restrictions restrictions{~bb::util::empty_bb, bb::util::empty_bb, king_sq};
+
+    if (!pos.checkers().empty()) {
+        const auto checker_sq = static_cast<square>(pos.checkers().get_lsb());
+        restrictions.check_mask = bb::attacks::get_between(king_sq, checker_sq) | pos.checkers();
+    }
+
+    // Enemy sliders that would attack the king if there were no pieces in between. A piece is
+    // pinned if it is the only one between the king and one of them
+    auto snipers = ((bb::attacks::get_bishop_attacks(king_sq, pos.occupancies(them))
+                     & (pos.piece_type_bb(piece_type::bishop) | queens))
+                    | (bb::attacks::get_rook_attacks(king_sq, pos.occupancies(them))
+                       & (pos.piece_type_bb(piece_type::rook) | queens)))
+                 & pos.occupancies(them);
+
+    while (!snipers.empty()) {
+        const auto sniper_sq = static_cast<square>(snipers.pop_lsb());
+        const auto blockers  = bb::attacks::get_between(king_sq, sniper_sq) & occupied;
+
+        if (blockers.bit_count() == 1)
+            restrictions.pinned |= blockers & pos.occupancies(us);
+    }
+
+    return restrictions;
+}
+
 template <color SideToMove>
-void generate_pawn_pushes(const board::position& pos, move_list& move_list) {
+void generate_pawn_pushes(const board::position&   pos,
+                          move_list&               move_list,
+                          const move_restrictions& restrictions) {
     constexpr color     us     = SideToMove;
     constexpr color     them   = ~us;
     constexpr direction offset = us == color::white ? direction::north : direction::south;
@@ -40,6 +95,9 @@ void generate_pawn_pushes(const board::position& pos, move_list& move_list) {
         const auto from        = to - offset;
         const auto moving_rank = rank_of(to);
 
+        if (!bb::bitboard::is_bit_set(restrictions.allowed(from), to))
+            continue;
+
         if (moving_rank != rank::rank_1 && moving_rank != rank::rank_8)
             move_list.push(move(from, to, move::move_flag::quiet));
         else {
@@ -53,12 +111,16 @@ void generate_pawn_pushes(const board::position& pos, move_list& move_list) {
     while (!double_push.empty()) {
         const auto to   = static_cast<square>(double_push.pop_lsb());
         const auto from = to - offset * 2;
-        move_list.push(move(from, to, move::move_flag::double_push));
+
+        if (bb::bitboard::is_bit_set(restrictions.allowed(from), to))
+            move_list.push(move(from, to, move::move_flag::double_push));
     }
 }
 
 template <color SideToMove>
-void generate_pawn_captures(const board::position& pos, move_list& move_list) {
+void generate_pawn_captures(const board::position&   pos,
+                            move_list&               move_list,
+                            const move_restrictions& restrictions) {
     constexpr color us        = SideToMove;
     constexpr color them      = ~us;
     auto            our_pawns = pos.piece_type_bb(piece_type::pawn) & pos.occupancies(us);
@@ -66,7 +128,8 @@ void generate_pawn_captures(const board::position& pos, move_list& move_list) {
     while (!our_pawns.empty()) {
         const auto from = static_cast<square>(our_pawns.pop_lsb());
         auto       possible_pawn_captures =
-            bb::attacks::get_pawn_attacks(from, us) & pos.occupancies(them);
+            bb::attacks::get_pawn_attacks(from, us) & pos.occupancies(them)
+            & restrictions.allowed(from);
 
         while (!possible_pawn_captures.empty()) {
             const auto to          = static_cast<square>(possible_pawn_captures.pop_lsb());
@@ -89,15 +152,21 @@ void generate_pawn_captures(const board::position& pos, move_list& move_list) {
 
         while (!ep_pawns.empty()) {
             const auto from = static_cast<square>(ep_pawns.pop_lsb());
-            move_list.push(move(from, pos.ep_square(), move::move_flag::en_passant));
+            const move ep_move(from, pos.ep_square(), move::move_flag::en_passant);
+
+            // En passant removes two pieces from the same rank, which may uncover an attack on
+            // the king that the pin masks can't see, so it is fully checked instead
+            if (pos.is_legal(ep_move))
+                move_list.push(ep_move);
         }
     }
 }
 
 template <color SideToMove>
-void generate_quiets_by_piece_type(const board::position& pos,
-                                   move_list&             move_list,
-                                   const piece_type       pt) {
+void generate_quiets_by_piece_type(const board::position&   pos,
+                                   move_list&               move_list,
+                                   const piece_type         pt,
+                                   const move_restrictions& restrictions) {
     constexpr color us         = SideToMove;
     constexpr color them       = ~us;
     const auto&     occupied   = pos.occupancies(us) | pos.occupancies(them);
@@ -106,7 +175,8 @@ void generate_quiets_by_piece_type(const board::position& pos,
     while (!our_pieces.empty()) {
         const auto from = static_cast<square>(our_pieces.pop_lsb());
         auto       possible_piece_moves =
-            bb::attacks::get_attacks_by_piece_type(pt, from, occupied) & ~occupied;
+            bb::attacks::get_attacks_by_piece_type(pt, from, occupied) & ~occupied
+            & restrictions.allowed(from);
 
         while (!possible_piece_moves.empty()) {
             const auto to = static_cast<square>(possible_piece_moves.pop_lsb());
@@ -116,9 +186,10 @@ void generate_quiets_by_piece_type(const board::position& pos,
 }
 
 template <color SideToMove>
-void generate_captures_by_piece_type(const board::position& pos,
-                                     move_list&             move_list,
-                                     const piece_type       pt) {
+void generate_captures_by_piece_type(const board::position&   pos,
+                                     move_list&               move_list,
+                                     const piece_type         pt,
+                                     const move_restrictions& restrictions) {
     constexpr color us         = SideToMove;
     constexpr color them       = ~us;
     const auto&     occupied   = pos.occupancies(us) | pos.occupancies(them);
@@ -127,7 +198,8 @@ void generate_captures_by_piece_type(const board::position& pos,
     while (!our_pieces.empty()) {
         const auto from = static_cast<square>(our_pieces.pop_lsb());
         auto       possible_piece_captures =
-            bb::attacks::get_attacks_by_piece_type(pt, from, occupied) & pos.occupancies(them);
+            bb::attacks::get_attacks_by_piece_type(pt, from, occupied) & pos.occupancies(them)
+            & restrictions.allowed(from);
 
         while (!possible_piece_captures.empty()) {
             const auto to = static_cast<square>(possible_piece_captures.pop_lsb());
@@ -136,6 +208,32 @@ void generate_captures_by_piece_type(const board::position& pos,
     }
 }
 
+/// @brief Generates the king moves to the given squares that don't step into an attack
+template <color SideToMove>
+void generate_king_moves(const board::position& pos,
+                         move_list&             move_list,
+                         const bb::bitboard&    targets,
+                         const move::move_flag  flag) {
+    constexpr color us   = SideToMove;
+    constexpr color them = ~us;
+
+    const square king_sq = pos.king_square(us);
+
+    // The king is removed from the occupancy, so that sliders attacking it keep attacking the
+    // squares behind it
+    auto occupied = pos.occupancies(us) | pos.occupancies(them);
+    bb::bitboard::clear_bit(occupied, king_sq);
+
+    auto possible_king_moves = bb::attacks::get_king_attacks(king_sq) & targets;
+
+    while (!possible_king_moves.empty()) {
+        const auto to = static_cast<square>(possible_king_moves.pop_lsb());
+
+        if ((pos.attackers_to(to, occupied) & pos.occupancies(them)).empty())
+            move_list.push(move(king_sq, to, flag));
+    }
+}
+
 template <color SideToMove>
 void generate_castling_moves(const board::position& pos, move_list& move_list) {
     if constexpr (SideToMove == color::white) {
@@ -152,74 +250,102 @@ void generate_castling_moves(const board::position& pos, move_list& move_list) {
     }
 }
 
-void generate_all_quiets(const board::position& pos, move_list& move_list) {
-    if (pos.side_to_move() == color::white) {
-        for (const piece_type pt : {piece_type::knight, piece_type::bishop, piece_type::rook,
-                                    piece_type::queen, piece_type::king})
-            generate_quiets_by_piece_type<color::white>(pos, move_list, pt);
-    }
-    else {
-        for (const piece_type pt : {piece_type::knight, piece_type::bishop, piece_type::rook,
-                                    piece_type::queen, piece_type::king})
-            generate_quiets_by_piece_type<color::black>(pos, move_list, pt);
+template <color SideToMove>
+void generate_quiets(const board::position& pos, move_list& move_list) {
+    const int   num_checkers = pos.checkers().bit_count();
+    const auto& empty        = ~(pos.occupancies(color::white) | pos.occupancies(color::black));
+
+    // In double check, only the king can move
+    if (num_checkers > 1) {
+        generate_king_moves<SideToMove>(pos, move_list, empty, move::move_flag::quiet);
+        return;
     }
+
+    const auto restrictions = get_move_restrictions<SideToMove>(pos);
+
+    generate_pawn_pushes<SideToMove>(pos, move_list, restrictions);
+
+    if (num_checkers == 0)
+        generate_castling_moves<SideToMove>(pos, move_list);
+
+    for (const piece_type pt :
+         {piece_type::knight, piece_type::bishop, piece_type::rook, piece_type::queen})
+        generate_quiets_by_piece_type<SideToMove>(pos, move_list, pt, restrictions);
+
+    generate_king_moves<SideToMove>(pos, move_list, empty, move::move_flag::quiet);
 }
 
-void generate_all_captures(const board::position& pos, move_list& move_list) {
-    if (pos.side_to_move() == color::white) {
-        generate_pawn_captures<color::white>(pos, move_list);
+template <color SideToMove>
+void generate_captures(const board::position& pos, move_list& move_list) {
+    const auto& targets = pos.occupancies(~SideToMove);
 
-        for (const piece_type pt : {piece_type::knight, piece_type::bishop, piece_type::rook,
-                                    piece_type::queen, piece_type::king})
-            generate_captures_by_piece_type<color::white>(pos, move_list, pt);
+    // In double check, only the king can move
+    if (pos.checkers().bit_count() > 1) {
+        generate_king_moves<SideToMove>(pos, move_list, targets, move::move_flag::capture);
+        return;
     }
-    else {
-        generate_pawn_captures<color::black>(pos, move_list);
 
-        for (const piece_type pt : {piece_type::knight, piece_type::bishop, piece_type::rook,
-                                    piece_type::queen, piece_type::king})
-            generate_captures_by_piece_type<color::black>(pos, move_list, pt);
-    }
+    const auto restrictions = get_move_restrictions<SideToMove>(pos);
+
+    generate_pawn_captures<SideToMove>(pos, move_list, restrictions);
+
+    for (const piece_type pt :
+         {piece_type::knight, piece_type::bishop, piece_type::rook, piece_type::queen})
+        generate_captures_by_piece_type<SideToMove>(pos, move_list, pt, restrictions);
+
+    generate_king_moves<SideToMove>(pos, move_list, targets, move::move_flag::capture);
 }
 
-void generate_all_moves(const board::position& pos, move_list& move_list) {
-    const int num_checkers = pos.checkers().bit_count();
+template <color SideToMove>
+void generate_evasions(const board::position& pos, move_list& move_list) {
+    const auto& targets = pos.occupancies(~SideToMove);
+    const auto& empty   = ~(pos.occupancies(color::white) | pos.occupancies(color::black));
 
-    if (num_checkers == 0) {
-        generate_all_captures(pos, move_list);
+    generate_king_moves<SideToMove>(pos, move_list, targets, move::move_flag::capture);
+    generate_king_moves<SideToMove>(pos, move_list, empty, move::move_flag::quiet);
 
-        if (pos.side_to_move() == color::white) {
-            generate_pawn_pushes<color::white>(pos, move_list);
-            generate_castling_moves<color::white>(pos, move_list);
-        }
-        else {
-            generate_pawn_pushes<color::black>(pos, move_list);
-            generate_castling_moves<color::black>(pos, move_list);
-        }
+    // In double check, only the king can move
+    if (pos.checkers().bit_count() > 1)
+        return;
 
-        generate_all_quiets(pos, move_list);
-    }
-    else if (num_checkers == 1) {
-        generate_all_captures(pos, move_list);
+    // The check mask only lets the other pieces capture the checker or block the check, and
+    // castling out of check is never legal
+    const auto restrictions = get_move_restrictions<SideToMove>(pos);
 
-        if (pos.side_to_move() == color::white)
-            generate_pawn_pushes<color::white>(pos, move_list);
-        else {
-            generate_pawn_pushes<color::black>(pos, move_list);
-        }
+    generate_pawn_captures<SideToMove>(pos, move_list, restrictions);
+    generate_pawn_pushes<SideToMove>(pos, move_list, restrictions);
 
-        generate_all_quiets(pos, move_list);
-    }
-    else {
-        if (pos.side_to_move() == color::white) {
-            generate_captures_by_piece_type<color::white>(pos, move_list, piece_type::king);
-            generate_quiets_by_piece_type<color::white>(pos, move_list, piece_type::king);
-        }
-        else {
-            generate_captures_by_piece_type<color::black>(pos, move_list, piece_type::king);
-            generate_quiets_by_piece_type<color::black>(pos, move_list, piece_type::king);
-        }
+    for (const piece_type pt :
+         {piece_type::knight, piece_type::bishop, piece_type::rook, piece_type::queen}) {
+        generate_captures_by_piece_type<SideToMove>(pos, move_list, pt, restrictions);
+        generate_quiets_by_piece_type<SideToMove>(pos, move_list, pt, restrictions);
     }
 }
 
+void generate_all_quiets(const board::position& pos, move_list& move_list) {
+    if (pos.side_to_move() == color::white)
+        generate_quiets<color::white>(pos, move_list);
+    else
+        generate_quiets<color::black>(pos, move_list);
+}
+
+void generate_all_captures(const board::position& pos, move_list& move_list) {
+    if (pos.side_to_move() == color::white)
+        generate_captures<color::white>(pos, move_list);
+    else
+        generate_captures<color::black>(pos, move_list);
+}
+
+void generate_all_evasions(const board::position& pos, move_list& move_list) {
+    if (pos.side_to_move() == color::white)
+        generate_evasions<color::white>(pos, move_list);
+    else
+        generate_evasions<color::black>(pos, move_list);
+}
+
+void generate_all_moves(const board::position& pos, move_list& move_list) {
+    generate_all_captures(pos, move_list);
+    generate_all_quiets(pos, move_list);
+}
+
 } // namespace moves
\ No newline at end of file
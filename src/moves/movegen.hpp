@@ -6,8 +6,20 @@
 
 namespace moves {
 
+/// @brief Generates the legal non-capturing moves, including quiet promotions and castling
 void generate_all_quiets(const board::position& pos, move_list& move_list);
+
+/// @brief Generates the legal captures, including capture promotions and en passant
 void generate_all_captures(const board::position& pos, move_list& move_list);
+
+/// @brief Generates the legal moves that get the king out of check: king moves and, in single
+/// check, captures of the checker and interpositions
+/// @note The side to move must be in check
+void generate_all_evasions(const board::position& pos, move_list& move_list);
+
+/// @brief Generates all the legal moves, captures first
+/// @note Checks and pins are resolved during generation, so the moves never need to be made to
+/// find out if they leave the king in check
 void generate_all_moves(const board::position& pos, move_list& move_list);
 
 } // namespace moves
\ No newline at end of file
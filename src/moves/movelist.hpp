@@ -1,15 +1,10 @@
 #pragma once
 
-#include <algorithm>
 #include <array>
 #include <cassert>
 
 #include "move.hpp"
 
-#include "../board/piece.hpp"
-#include "../board/position.hpp"
-#include "../search/search.hpp"
-
 namespace moves {
 
 struct scored_move {
@@ -32,17 +27,6 @@ class move_list {
 
         void clear() { m_size = 0; }
 
-        void score_moves(move                       tt_move,
-                         const board::position&     pos,
-                         const search::search_data& search_data,
-                         int                        ply);
-
-        void sort() {
-            std::stable_sort(begin(), end(), [](const scored_move a, const scored_move b) {
-                return std::greater()(a.move_score, b.move_score);
-            });
-        }
-
         [[nodiscard]] usize size() const { return m_size; }
 
         [[nodiscard]] move move_at(const usize index) const {
@@ -0,0 +1,210 @@
+#include "movepicker.hpp"
+
+#include <algorithm>
+
+#include "movegen.hpp"
+#include "see.hpp"
+
+#include "../board/piece.hpp"
+#include "../utils/mdarray.hpp"
+
+namespace moves {
+
+// clang-format off
+/// @brief MVV-LVA (Most Valuable Victim - Least Valuable Attacker) table, used for move
+/// ordering and indexed by [attacker][victim]
+constexpr utils::mdarray<score, constants::num_piece_types, constants::num_piece_types + 1> mvv_lva = {{
+    {{105, 205, 305, 405, 505, 0, 0}, // attacker -> PAWN
+    {104, 204, 303, 404, 504, 0, 0}, // attacker -> KNIGHT
+    {103, 203, 303, 403, 503, 0, 0}, // attacker -> BISHOP
+    {102, 202, 302, 402, 502, 0, 0}, // attacker -> ROOK
+    {101, 201, 301, 401, 501, 0, 0}, // attacker -> QUEEN
+    {100, 200, 300, 400, 500, 0, 0}}  // attacker -> KING
+}};
+// clang-format on
+
+move_picker::move_picker(const board::position&     pos,
+                         const move                 tt_move,
+                         const search::search_data& search_data,
+                         const int                  ply,
+                         const bool                 captures_only) :
+    m_pos(pos),
+    m_search_data(search_data),
+    m_tt_move(move::null()),
+    m_first_killer(captures_only ? move::null() : search_data.first_killer(ply)),
+    m_second_killer(captures_only ? move::null() : search_data.second_killer(ply)),
+    m_stage(stage::tt_move),
+    m_captures_only(captures_only),
+    m_evasions(captures_only && !pos.checkers().empty()) {
+    // The transposition table move may come from a different position (key collisions), so it
+    // has to be validated before searching it
+    if (tt_move != move::null() && (!captures_only || m_evasions || tt_move.is_capture())
+        && pos.is_pseudo_legal(tt_move) && pos.is_legal(tt_move))
+        m_tt_move = tt_move;
+}
+
+move move_picker::next() {
+    switch (m_stage) {
+    case stage::tt_move:
+        m_stage = m_evasions ? stage::generate_evasions : stage::generate_captures;
+
+        if (m_tt_move != move::null())
+            return m_tt_move;
+
+        return next();
+    case stage::generate_captures:
+        generate_all_captures(m_pos, m_move_list);
+        score_captures();
+        m_stage = stage::good_captures;
+
+        [[fallthrough]];
+    case stage::good_captures:
+        while (m_index < m_move_list.size()) {
+            const move current_move = pick_best();
+
+            if (current_move == m_tt_move)
+                continue;
+
+            // Losing captures are moved to the front of the list, where the already picked moves
+            // were, and searched after the quiet moves
+            if (!m_captures_only && !see(m_pos, current_move, 0)) {
+                m_move_list.begin()[m_bad_captures_end++] = m_move_list.begin()[m_index - 1];
+                continue;
+            }
+
+            return current_move;
+        }
+
+        if (m_captures_only) {
+            m_stage = stage::done;
+            return move::null();
+        }
+
+        m_stage = stage::first_killer;
+
+        [[fallthrough]];
+    case stage::first_killer:
+        m_stage = stage::second_killer;
+
+        if (is_valid_killer(m_first_killer))
+            return m_first_killer;
+
+        m_first_killer = move::null();
+
+        [[fallthrough]];
+    case stage::second_killer:
+        m_stage = stage::generate_quiets;
+
+        if (m_second_killer != m_first_killer && is_valid_killer(m_second_killer))
+            return m_second_killer;
+
+        m_second_killer = move::null();
+
+        [[fallthrough]];
+    case stage::generate_quiets:
+        m_index = m_move_list.size();
+
+        generate_all_quiets(m_pos, m_move_list);
+        score_quiets();
+        m_stage = stage::quiets;
+
+        [[fallthrough]];
+    case stage::quiets:
+        while (m_index < m_move_list.size()) {
+            const move current_move = pick_best();
+
+            if (current_move != m_tt_move && current_move != m_first_killer
+                && current_move != m_second_killer)
+                return current_move;
+        }
+
+        m_index = 0;
+        m_stage = stage::bad_captures;
+
+        [[fallthrough]];
+    case stage::bad_captures:
+        // Bad captures were already sorted when they were deferred
+        if (m_index < m_bad_captures_end)
+            return m_move_list.move_at(m_index++);
+
+        m_stage = stage::done;
+        return move::null();
+
+    case stage::generate_evasions:
+        generate_all_evasions(m_pos, m_move_list);
+        score_evasions();
+        m_stage = stage::evasions;
+
+        [[fallthrough]];
+    case stage::evasions:
+        while (m_index < m_move_list.size()) {
+            const move current_move = pick_best();
+
+            if (current_move != m_tt_move)
+                return current_move;
+        }
+
+        m_stage = stage::done;
+
+        [[fallthrough]];
+    case stage::done:
+        return move::null();
+    }
+
+    std::unreachable();
+}
+
+void move_picker::score_captures() {
+    for (auto& [move_score, move_value] : m_move_list) {
+        const auto attacker_piece_type =
+            board::pieces::piece_to_piece_type(m_pos.piece_on(move_value.from()));
+        const auto victim_piece_type =
+            board::pieces::piece_to_piece_type(m_pos.piece_on(move_value.to()));
+
+        move_score = mvv_lva[std::to_underlying(attacker_piece_type),
+                             std::to_underlying(victim_piece_type)]
+                   + search::move_ordering::mvv_lva_base_bonus;
+    }
+}
+
+void move_picker::score_quiets() {
+    for (auto it = m_move_list.begin() + m_index; it != m_move_list.end(); ++it)
+        it->move_score = m_search_data.quiet_history_value(it->move_value);
+}
+
+void move_picker::score_evasions() {
+    for (auto& [move_score, move_value] : m_move_list) {
+        if (move_value.is_capture()) {
+            const auto attacker_piece_type =
+                board::pieces::piece_to_piece_type(m_pos.piece_on(move_value.from()));
+            const auto victim_piece_type =
+                board::pieces::piece_to_piece_type(m_pos.piece_on(move_value.to()));
+
+            move_score = mvv_lva[std::to_underlying(attacker_piece_type),
+                                 std::to_underlying(victim_piece_type)]
+                       + search::move_ordering::mvv_lva_base_bonus;
+        }
+        else
+            move_score = m_search_data.quiet_history_value(move_value);
+    }
+}
+
+move move_picker::pick_best() {
+    const auto first = m_move_list.begin() + m_index;
+    const auto best  = std::max_element(first, m_move_list.end(),
+                                       [](const scored_move& a, const scored_move& b) {
+                                           return a.move_score < b.move_score;
+                                       });
+
+    std::iter_swap(first, best);
+    ++m_index;
+
+    return first->move_value;
+}
+
+bool move_picker::is_valid_killer(const move killer) const {
+    return killer != move::null() && killer != m_tt_move && killer.is_quiet()
+        && m_pos.is_pseudo_legal(killer) && m_pos.is_legal(killer);
+}
+
+} // namespace moves
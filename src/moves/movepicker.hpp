@@ -0,0 +1,78 @@
+#pragma once
+
+#include "movelist.hpp"
+
+#include "../board/position.hpp"
+#include "../search/search.hpp"
+
+namespace moves {
+
+/// @class move_picker
+/// @brief Hands out the moves of a position one by one, in the order they are expected to be the
+/// best ones. Moves are generated and sorted lazily by stages, since most cut-nodes fail high on
+/// the transposition table move or on one of the first captures. Captures that lose material
+/// according to SEE are deferred until all the quiet moves have been picked
+class move_picker {
+    public:
+        enum class stage : u8 {
+            tt_move,
+            generate_captures,
+            good_captures,
+            first_killer,
+            second_killer,
+            generate_quiets,
+            quiets,
+            bad_captures,
+            generate_evasions,
+            evasions,
+            done
+        };
+
+        /// @param pos Position to pick the moves from
+        /// @param tt_move Move from the transposition table, which is tried first if pseudo-legal
+        /// @param search_data Killer moves and history used to sort the moves
+        /// @param ply Internal depth of the search tree, to retrieve the killer moves
+        /// @param captures_only Only pick captures (quiescence search), without splitting them into
+        /// good and bad captures. When in check, all the evasions are picked instead
+        move_picker(const board::position&     pos,
+                    move                       tt_move,
+                    const search::search_data& search_data,
+                    int                        ply,
+                    bool                       captures_only);
+
+        /// @brief Picks the next pseudo-legal move to search
+        /// @returns The next move, or a null move once all the moves have been picked
+        [[nodiscard]] move next();
+
+        [[nodiscard]] stage current_stage() const { return m_stage; }
+
+    private:
+        void score_captures();
+
+        void score_quiets();
+
+        /// @brief Scores the evasions, captures by MVV-LVA ahead of the quiet moves by history
+        void score_evasions();
+
+        /// @brief Moves the best scored move that has not been picked yet to the front (selection
+        /// sort), so that only the moves that are actually searched get sorted
+        /// @returns The best remaining move of the list
+        [[nodiscard]] move pick_best();
+
+        /// @brief Checks if a killer move can be searched in the current position
+        [[nodiscard]] bool is_valid_killer(move killer) const;
+
+        const board::position&     m_pos;
+        const search::search_data& m_search_data;
+        move_list                  m_move_list;
+        usize                      m_index{};
+        usize                      m_bad_captures_end{};
+        move                       m_tt_move;
+        move                       m_first_killer;
+        move                       m_second_killer;
+        stage                      m_stage;
+        bool                       m_captures_only;
+        bool                       m_evasions;
+};
+
+} // namespace moves
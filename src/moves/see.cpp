@@ -0,0 +1,98 @@
+#include "see.hpp"
+
+#include "../board/bitboard/attacks.hpp"
+#include "../board/piece.hpp"
+
+namespace moves {
+
+namespace bb = board::bitboards;
+
+bool see(const board::position& pos, const move move, const score threshold) {
+    if (move.is_castling())
+        return threshold <= 0;
+
+    const square from = move.from();
+    const square to   = move.to();
+
+    const piece_type victim = move.is_en_passant()
+                                ? piece_type::pawn
+                                : board::pieces::piece_to_piece_type(pos.piece_on(to));
+    const piece_type attacker = board::pieces::piece_to_piece_type(pos.piece_on(from));
+
+    // Balance after capturing: if it is not enough even without recapture, the move fails
+    int balance = see_values[std::to_underlying(victim)] - threshold;
+
+    if (balance < 0)
+        return false;
+
+    // Balance after losing the capturing piece: if it is still enough, the move succeeds
+    balance -= see_values[std::to_underlying(attacker)];
+
+    if (balance >= 0)
+        return true;
+
+    const auto& bishops_queens =
+        pos.piece_type_bb(piece_type::bishop) | pos.piece_type_bb(piece_type::queen);
+    const auto& rooks_queens =
+        pos.piece_type_bb(piece_type::rook) | pos.piece_type_bb(piece_type::queen);
+
+    bb::bitboard occupied = pos.occupancies(color::white) | pos.occupancies(color::black);
+
+    bb::bitboard::clear_bit(occupied, from);
+    bb::bitboard::set_bit(occupied, to);
+
+    if (move.is_en_passant()) {
+        const direction offset =
+            pos.side_to_move() == color::white ? direction::north : direction::south;
+        bb::bitboard::clear_bit(occupied, to - offset);
+    }
+
+    bb::bitboard attackers = pos.attackers_to(to, occupied) & occupied;
+    color        stm       = ~pos.side_to_move();
+
+    // Each iteration, the side to move recaptures with its least valuable attacker. The side that
+    // runs out of attackers, or that would only make the balance worse, loses the exchange
+    while (true) {
+        const bb::bitboard our_attackers = attackers & pos.occupancies(stm);
+
+        if (our_attackers.empty())
+            break;
+
+        piece_type next_attacker = piece_type::pawn;
+
+        while ((our_attackers & pos.piece_type_bb(next_attacker)).empty())
+            next_attacker = static_cast<piece_type>(std::to_underlying(next_attacker) + 1);
+
+        // The king can't capture if the square is still defended
+        if (next_attacker == piece_type::king
+            && !(attackers & pos.occupancies(~stm) & occupied).empty())
+            break;
+
+        stm = ~stm;
+
+        // Negamax the balance: after recapturing, the balance is from the other side's view
+        balance = -balance - 1 - see_values[std::to_underlying(next_attacker)];
+
+        if (balance >= 0)
+            break;
+
+        const auto attacker_sq =
+            static_cast<square>((our_attackers & pos.piece_type_bb(next_attacker)).get_lsb());
+        bb::bitboard::clear_bit(occupied, attacker_sq);
+
+        // Removing the attacker may uncover x-ray attackers behind it
+        if (next_attacker == piece_type::pawn || next_attacker == piece_type::bishop
+            || next_attacker == piece_type::queen)
+            attackers |= bb::attacks::get_bishop_attacks(to, occupied) & bishops_queens;
+
+        if (next_attacker == piece_type::rook || next_attacker == piece_type::queen)
+            attackers |= bb::attacks::get_rook_attacks(to, occupied) & rooks_queens;
+
+        attackers &= occupied;
+    }
+
+    // The side to move after the loop is the one that lost the exchange
+    return stm != pos.side_to_move();
+}
+
+} // namespace moves
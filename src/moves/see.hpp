@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+
+#include "move.hpp"
+
+#include "../board/position.hpp"
+
+namespace moves {
+
+/// @brief Piece values used by the static exchange evaluation, indexed by piece type
+inline constexpr std::array<score, constants::num_piece_types + 1> see_values = {
+    100, 300, 300, 500, 900, 0, 0};
+
+/// @brief Static Exchange Evaluation: Resolves the sequence of captures on the target square of
+/// the move, each side capturing with its least valuable attacker and being able to stop at any
+/// point. X-ray attackers behind the capturing sliders are taken into account
+/// @param pos Position where the move is made
+/// @param move Move to evaluate
+/// @param threshold Minimum material balance required
+/// @returns true if the move wins at least threshold material
+/// @note Pins, promotions and castling are not considered. See
+/// https://www.chessprogramming.org/Static_Exchange_Evaluation for reference
+[[nodiscard]] bool see(const board::position& pos, move move, score threshold);
+
+} // namespace moves
@@ -1,63 +1,154 @@
 #include "perft.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <format>
-#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include "../moves/movegen.hpp"
 #include "../moves/movelist.hpp"
+#include "../utils/io.hpp"
 #include "../utils/time.hpp"
 
-u64 perft(const board::position& pos, const int depth) {
-    if (depth == 0)
+/// @class perft_table
+/// @brief Caches the leaf count of already visited subtrees, indexed by zobrist key and depth
+/// @note The table is shared by all the perft threads without locking. The key is stored xored
+/// with the data, so an entry that is being written by another thread simply fails to match
+class perft_table {
+    public:
+        explicit perft_table(const usize size_mb) :
+            m_entries(std::max<usize>(1, size_mb * 1024 * 1024 / sizeof(perft_entry))) {}
+
+        [[nodiscard]] bool probe(const zobrist_key key, const int depth, u64& nodes) const {
+            const auto& entry = m_entries[index(key)];
+            const u64   data  = entry.data.load(std::memory_order_relaxed);
+            const u64   check = entry.check.load(std::memory_order_relaxed);
+
+            if ((check ^ data) != key || (data & depth_mask) != static_cast<u64>(depth))
+                return false;
+
+            nodes = data >> depth_bits;
+            return true;
+        }
+
+        void store(const zobrist_key key, const int depth, const u64 nodes) {
+            auto&     entry = m_entries[index(key)];
+            const u64 data  = nodes << depth_bits | static_cast<u64>(depth);
+
+            entry.check.store(key ^ data, std::memory_order_relaxed);
+            entry.data.store(data, std::memory_order_relaxed);
+        }
+
+    private:
+        struct perft_entry {
+                std::atomic<u64> check;
+                std::atomic<u64> data;
+        };
+
+        static constexpr u64 depth_bits = 8;
+        static constexpr u64 depth_mask = (1ULL << depth_bits) - 1;
+
+        [[nodiscard]] u64 index(const zobrist_key key) const {
+            return (static_cast<u128>(key) * static_cast<u128>(m_entries.size())) >> 64;
+        }
+
+        std::vector<perft_entry> m_entries;
+};
+
+u64 perft(board::position& pos, const int depth, perft_table* table) {
+    if (depth <= 0)
         return 1ULL;
 
-    u64              nodes = 0ULL;
+    u64 nodes = 0ULL;
+
+    // Last level subtrees are cheaper to count than to look up
+    const bool use_table = table != nullptr && depth > 1;
+
+    if (use_table && table->probe(pos.key(), depth, nodes))
+        return nodes;
+
     moves::move_list move_list;
     generate_all_moves(pos, move_list);
 
-    for (u32 i = 0; i < move_list.size(); ++i) {
-        board::position copy = pos;
-        copy.make_move<false>(move_list.move_at(i));
+    // Bulk counting: The generated moves are legal, so at the last level there is no need to make
+    // them
+    if (depth == 1)
+        return move_list.size();
 
-        if (!copy.was_legal())
-            continue;
-
-        nodes += perft(copy, depth - 1);
+    for (const auto& [move_score, current_move] : move_list) {
+        pos.make_move(current_move);
+        nodes += perft(pos, depth - 1, table);
+        pos.unmake_move(current_move);
     }
 
+    if (use_table)
+        table->store(pos.key(), depth, nodes);
+
     return nodes;
 }
 
-void split_perft(const board::position& pos, const int depth) {
-    std::cout << std::format("\nRunning performance test...\n") << std::endl;
+u64 perft(board::position& pos, const int depth) { return perft(pos, depth, nullptr); }
+
+u64 split_perft(const board::position& pos,
+                const int              depth,
+                const usize            thread_count,
+                const usize            hash_mb) {
+    utils::io::print_line("\nRunning performance test...\n");
 
-    const auto       base_pos = board::position::copy_without_hash_history(pos);
     moves::move_list move_list;
-    generate_all_moves(base_pos, move_list);
+    generate_all_moves(pos, move_list);
 
-    u64       total_nodes = 0ULL;
-    const u64 start_time  = utils::time::get_time_ms();
+    std::vector<moves::move> root_moves;
 
-    for (u32 i = 0; i < move_list.size(); ++i) {
-        auto       copy         = base_pos;
-        const auto current_move = move_list.move_at(i);
-        copy.make_move<false>(current_move);
+    for (const auto& [move_score, current_move] : move_list)
+        root_moves.push_back(current_move);
 
-        if (!copy.was_legal())
-            continue;
+    const auto table =
+        hash_mb > 0 ? std::make_unique<perft_table>(std::min(hash_mb, max_perft_hash_mb)) : nullptr;
+    std::vector<u64>   root_nodes(root_moves.size());
+    std::atomic<usize> next_root_move{0};
 
-        const u64 value = perft(copy, depth - 1);
-        total_nodes += value;
+    const u64 start_time = utils::time::get_time_ms();
 
-        std::cout << std::format("{}: {}", current_move.to_string(), value) << std::endl;
-    }
+    // Root moves are handed out one at a time, so that threads that finish early keep taking the
+    // remaining ones
+    auto count_root_moves = [&] {
+        auto thread_pos = pos;
+
+        for (usize i = next_root_move.fetch_add(1, std::memory_order_relaxed);
+             i < root_moves.size(); i = next_root_move.fetch_add(1, std::memory_order_relaxed)) {
+            thread_pos.make_move(root_moves[i]);
+            root_nodes[i] = perft(thread_pos, depth - 1, table.get());
+            thread_pos.unmake_move(root_moves[i]);
+        }
+    };
+
+    std::vector<std::thread> helpers;
+
+    for (usize i = 1; i < thread_count; ++i)
+        helpers.emplace_back(count_root_moves);
+
+    count_root_moves();
+
+    for (auto& helper : helpers)
+        helper.join();
 
     const auto elapsed = utils::time::get_time_ms() - start_time;
 
-    std::cout << std::format("\nDepth           : {}", depth) << std::endl;
-    std::cout << std::format("Total nodes     : {}", total_nodes) << std::endl;
-    std::cout << std::format("Total time      : {} ms", elapsed) << std::endl;
-    std::cout << std::format("Nodes per second: {}\n",
-                             total_nodes / std::max<u64>(1, elapsed) * 1000)
-              << std::endl;
+    u64 total_nodes = 0ULL;
+
+    for (usize i = 0; i < root_moves.size(); ++i) {
+        total_nodes += root_nodes[i];
+        utils::io::print_line(std::format("{}: {}", root_moves[i].to_string(), root_nodes[i]));
+    }
+
+    utils::io::print_line(std::format("\nDepth           : {}", depth));
+    utils::io::print_line(std::format("Total nodes     : {}", total_nodes));
+    utils::io::print_line(std::format("Total time      : {} ms", elapsed));
+    utils::io::print_line(std::format("Nodes per second: {}\n",
+                                      total_nodes / std::max<u64>(1, elapsed) * 1000));
+
+    return total_nodes;
 }
@@ -4,5 +4,21 @@
 
 #include "../board/position.hpp"
 
-u64  perft(const board::position& pos, int depth);
-void split_perft(const board::position& pos, int depth);
+/// @brief Counts the leaf nodes of the legal move tree up to the given depth
+/// @param pos Position to start from
+/// @param depth Depth of the move tree
+/// @returns The number of leaf nodes
+u64 perft(board::position& pos, int depth);
+
+/// @brief Maximum size of the table used to cache subtree counts, in MB. It is allocated on top of
+/// the transposition table, so it is kept small regardless of the requested size
+inline constexpr usize max_perft_hash_mb = 256;
+
+/// @brief Runs perft, printing the number of leaf nodes below every root move
+/// @param pos Position to start from
+/// @param depth Depth of the move tree
+/// @param thread_count Number of threads the root moves are split across
+/// @param hash_mb Size of the table used to cache subtree counts, in MB (0 to disable it), capped
+/// to max_perft_hash_mb
+/// @returns The total number of leaf nodes
+u64 split_perft(const board::position& pos, int depth, usize thread_count = 1, usize hash_mb = 0);
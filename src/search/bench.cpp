@@ -1,11 +1,11 @@
 #include "bench.hpp"
 
 #include <format>
-#include <iostream>
 
+#include "../utils/io.hpp"
 #include "../utils/time.hpp"
 
-void search::bench::run(searcher& searcher, const u32 depth) {
+void search::bench::run(thread_pool& threads, const u32 depth) {
     // clang-format off
     const std::array bench_fens = {
         #include "./resources/bench.csv"
@@ -14,23 +14,23 @@ void search::bench::run(searcher& searcher, const u32 depth) {
 
     const u64 start_time = utils::time::get_time_ms();
     u64       total_nodes{};
-    searcher.set_limits(UINT64_MAX, UINT64_MAX, depth);
+    threads.set_limits(UINT64_MAX, UINT64_MAX, depth);
 
     for (const auto& fen : bench_fens) {
         board::position pos(fen);
 
-        searcher.set_start_time(utils::time::get_time_ms());
-        searcher.main_search(pos);
+        threads.set_start_time(utils::time::get_time_ms());
+        threads.start_search(pos, false);
+        threads.wait();
 
-        total_nodes += searcher.searched_nodes();
+        total_nodes += threads.searched_nodes();
     }
 
     const u64  elapsed = utils::time::get_time_ms() - start_time;
     const auto seconds = elapsed / 1000;
 
-    std::cout << std::format("\ninfo string {} seconds", seconds) << std::endl;
-    std::cout << std::format(
+    utils::io::print_line(std::format("\ninfo string {} seconds", seconds));
+    utils::io::print_line(std::format(
         "{} nodes {} nps", total_nodes,
-        static_cast<u64>(static_cast<double>(total_nodes) / static_cast<double>(seconds)))
-              << std::endl;
+        static_cast<u64>(static_cast<double>(total_nodes) / static_cast<double>(seconds))));
 }
@@ -1,9 +1,9 @@
 #pragma once
 
-#include "search.hpp"
+#include "threads.hpp"
 
 namespace search::bench {
 
-void run(searcher& searcher, u32 depth);
+void run(thread_pool& threads, u32 depth);
 
 }
\ No newline at end of file
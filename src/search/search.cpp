@@ -2,14 +2,16 @@
 
 #include <cmath>
 #include <format>
-#include <iostream>
 #include <limits>
 #include <stdexcept>
 
+#include "threads.hpp"
 #include "tt.hpp"
 
 #include "../eval/eval.hpp"
-#include "../moves/movegen.hpp"
+#include "../moves/movepicker.hpp"
+#include "../moves/see.hpp"
+#include "../utils/io.hpp"
 #include "../utils/mdarray.hpp"
 #include "../utils/parsing.hpp"
 #include "../utils/time.hpp"
@@ -43,8 +45,21 @@ static const auto lmr_table = [] {
 constexpr int lmr_min_depth      = 2;
 constexpr int lmr_move_threshold = 3;
 
+constexpr int   aspiration_min_depth = 5;
+constexpr score aspiration_window    = 40;
+
 } // namespace heuristics
 
+namespace lazy_smp {
+
+// Helper threads skip some iterations of the iterative deepening loop, so that they search at
+// different depths than the main thread and fill the shared transposition table with more diverse
+// information. The skipping pattern is taken from older versions of Stockfish
+constexpr std::array skip_size  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr std::array skip_phase = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+} // namespace lazy_smp
+
 void searcher::reset() {
     m_info.stopped        = false;
     m_info.searched_nodes = 0ULL;
@@ -57,6 +72,9 @@ void searcher::set_limits(const u64 nodes_limit, const u64 time_limit, const u32
     m_limits.nodes_limit = nodes_limit;
     m_limits.time_limit  = time_limit;
     m_limits.depth_limit = depth_limit;
+
+    // Only searches with a clock (see parse_time_control) have soft and hard time limits
+    m_timer = time_manager();
 }
 
 void searcher::set_start_time(const u64 time) { m_timer.set_start_time(time); }
@@ -64,15 +82,16 @@ void searcher::set_start_time(const u64 time) { m_timer.set_start_time(time); }
 void searcher::parse_time_control(const std::vector<std::string>& command, const color stm) {
     u64 base_time{};
     u16 increment{};
+    u16 moves_to_go{};
+
+    set_limits(std::numeric_limits<u64>::max(), std::numeric_limits<u64>::max(),
+               constants::max_depth);
 
-    auto set_base_time_and_limits = [&](const std::optional<u64> parsed_base_time) -> void {
-        if (parsed_base_time) {
+    auto set_base_time = [&](const std::optional<u64> parsed_base_time) -> void {
+        if (parsed_base_time)
             base_time = parsed_base_time.value();
-            set_limits(std::numeric_limits<u64>::max(), base_time, constants::max_depth);
-        }
-        else {
+        else
             throw std::runtime_error("Failed to parse base time.\n");
-        }
     };
 
     auto set_increment = [&](const std::optional<u16> parsed_increment) -> void {
@@ -85,52 +104,201 @@ void searcher::parse_time_control(const std::vector<std::string>& command, const
     for (auto it = command.begin() + 1; it < command.end(); ++it) {
         if (stm == color::white) {
             if (*it == "wtime")
-                set_base_time_and_limits(utils::parsing::to_number<u64>(*(it + 1)));
+                set_base_time(utils::parsing::to_number<u64>(*(it + 1)));
 
             if (*it == "winc")
                 set_increment(utils::parsing::to_number<u16>(*(it + 1)));
         }
         else {
             if (*it == "btime")
-                set_base_time_and_limits(utils::parsing::to_number<u64>(*(it + 1)));
+                set_base_time(utils::parsing::to_number<u64>(*(it + 1)));
 
             if (*it == "binc")
                 set_increment(utils::parsing::to_number<u16>(*(it + 1)));
         }
+
+        if (*it == "movestogo") {
+            if (const auto parsed_moves_to_go = utils::parsing::to_number<u16>(*(it + 1)))
+                moves_to_go = parsed_moves_to_go.value();
+            else
+                throw std::runtime_error("Failed to parse moves to go.\n");
+        }
     }
-    m_timer = time_manager(utils::time::get_time_ms(), base_time, increment);
+
+    m_timer = time_manager(utils::time::get_time_ms(), base_time, increment, moves_to_go,
+                           m_pool.move_overhead());
 }
 
-void searcher::main_search(const board::position& pos) {
-    reset();
-    auto best_move = moves::move::null();
+moves::move searcher::main_search(const board::position& pos) {
+    auto  root_pos   = pos;
+    auto  best_move  = moves::move::null();
+    score best_score = 0;
+
+    // Every thread updates its own accumulators, which are only needed with a network loaded
+    root_pos.set_accumulators(eval::nnue::network_loaded() ? &m_accumulators : nullptr);
+
+    // The root moves start in the order the move picker would search them, and are sorted by
+    // their scores after every iteration
+    tt::tt_entry entry;
+
+    const auto tt_move =
+        tt::global_tt.probe(root_pos.key(), entry) ? entry.move() : moves::move::null();
+
+    moves::move_picker move_picker(root_pos, tt_move, m_data, 0, false);
+    moves::move        current_move;
+
+    const auto& search_moves = m_pool.search_moves();
+
+    m_root_moves.clear();
+
+    while ((current_move = move_picker.next()) != moves::move::null()) {
+        if (search_moves.empty()
+            || std::ranges::find(search_moves, current_move) != search_moves.end())
+            m_root_moves.push_back(root_move{current_move});
+    }
+
+    // Helpers only search the best line, the extra ones are just for reporting
+    const usize multi_pv =
+        is_main_thread() ? std::min(m_pool.multi_pv(), m_root_moves.size()) : 1;
+
+    int   best_move_stability = 0;
+    score previous_score      = 0;
 
     // Iterative deepening loop
     for (int current_depth = 1; current_depth <= m_limits.depth_limit; ++current_depth) {
-        const score best_score =
-            negamax<true>(pos, -constants::score_infinite, constants::score_infinite, current_depth,
-                          0, m_info.pv);
+        if (!is_main_thread()) {
+            const usize helper_index = (m_thread_id - 1) % lazy_smp::skip_size.size();
+
+            if ((current_depth + lazy_smp::skip_phase[helper_index])
+                / lazy_smp::skip_size[helper_index] % 2)
+                continue;
+        }
+
+        for (auto& current_root_move : m_root_moves)
+            current_root_move.previous_score = current_root_move.current_score;
+
+        // Search the root once per line, excluding the best moves of the previous lines. After
+        // each search, the remaining moves are sorted by their new scores, so the next line
+        // starts with the second best move. A line may still end up scoring above the previous
+        // ones, so the lines searched so far are sorted as well. Mates and stalemates have no
+        // moves to search
+        for (m_pv_index = 0; m_pv_index < std::max<usize>(multi_pv, 1); ++m_pv_index) {
+            const score line_score = m_root_moves.empty()
+                                       ? best_score
+                                       : m_root_moves[m_pv_index].previous_score;
+
+            best_score = aspiration_search(root_pos, current_depth, line_score);
+
+            if (m_root_moves.empty())
+                break;
+
+            std::ranges::stable_sort(m_root_moves.begin() + m_pv_index, m_root_moves.end(),
+                                     std::ranges::greater{}, &root_move::current_score);
+
+            if (m_info.stopped)
+                break;
+
+            std::ranges::stable_sort(m_root_moves.begin(), m_root_moves.begin() + m_pv_index + 1,
+                                     std::ranges::greater{}, &root_move::current_score);
+        }
 
         if (m_info.stopped) {
             // If search stopped too early and we don't have a best move, we update it in order to
             // avoid sending illegal moves to GUI
-            if (best_move == moves::move::null())
-                best_move = m_info.pv.best_move();
+            if (best_move == moves::move::null() && !m_root_moves.empty())
+                best_move = m_root_moves.front().move;
 
             break;
         }
 
+        const auto previous_best_move = best_move;
+
         // Ensure we only update the best move if search was not cancelled. Otherwise, our best
         // move may be terrible
-        best_move = m_info.pv.best_move();
-        report_info(m_timer.elapsed(), current_depth, best_score, m_info.pv);
+        if (!m_root_moves.empty()) {
+            best_move  = m_root_moves.front().move;
+            best_score = m_root_moves.front().current_score;
+        }
+
+        if (!is_main_thread())
+            continue;
+
+        if (m_root_moves.empty())
+            report_info(m_timer.elapsed(), current_depth, 0, best_score, m_info.pv);
+
+        for (usize i = 0; i < multi_pv; ++i)
+            report_info(m_timer.elapsed(), current_depth, i, m_root_moves[i].current_score,
+                        m_root_moves[i].pv);
+
+        // A new iteration takes longer than all the previous ones together, so once the soft
+        // limit is reached it would most likely be aborted before finishing
+        best_move_stability = best_move == previous_best_move ? best_move_stability + 1 : 0;
+
+        // An obvious move takes most of the nodes, since all the alternatives are refuted quickly
+        const double best_move_node_fraction =
+            m_root_moves.empty() ? 0.0
+                                 : static_cast<double>(m_root_moves.front().nodes)
+                                       / static_cast<double>(std::max<u64>(searched_nodes(), 1));
+
+        m_timer.scale_soft_limit(best_move_stability,
+                                 current_depth > 1 ? previous_score - best_score : 0,
+                                 best_move_node_fraction);
+
+        if (m_timer.soft_limit_reached())
+            break;
+
+        previous_score = best_score;
+    }
+
+    return best_move;
+}
+
+score searcher::aspiration_search(board::position& root_pos,
+                                  const int        depth,
+                                  const score      previous_score) {
+    score window = heuristics::aspiration_window;
+    score alpha  = -constants::score_infinite;
+    score beta   = constants::score_infinite;
+
+    // Scores of shallow iterations are too unstable to be a good guess
+    if (depth >= heuristics::aspiration_min_depth) {
+        alpha = std::max<score>(previous_score - window, -constants::score_infinite);
+        beta  = std::min<score>(previous_score + window, constants::score_infinite);
+    }
+
+    while (true) {
+        const score current_score = negamax<true>(root_pos, alpha, beta, depth, 0, m_info.pv);
+
+        if (m_info.stopped)
+            return current_score;
+
+        // The true score is outside of the window, so search again with a wider one. On a
+        // fail-low, beta is also lowered to get a cheaper search
+        if (current_score <= alpha) {
+            beta  = (alpha + beta) / 2;
+            alpha = std::max<score>(current_score - window, -constants::score_infinite);
+
+            if (is_main_thread())
+                report_info(m_timer.elapsed(), depth, m_pv_index, current_score, m_info.pv,
+                            score_bound::upper);
+        }
+        else if (current_score >= beta) {
+            beta = std::min<score>(current_score + window, constants::score_infinite);
+
+            if (is_main_thread())
+                report_info(m_timer.elapsed(), depth, m_pv_index, current_score, m_info.pv,
+                            score_bound::lower);
+        }
+        else
+            return current_score;
+
+        window += window / 2;
     }
-    std::cout << std::format("bestmove {}", best_move.to_string()) << std::endl;
 }
 
 template <bool pv_node>
-score searcher::qsearch(const board::position& pos, score alpha, const score beta, const int ply) {
-    ++m_info.searched_nodes;
+score searcher::qsearch(board::position& pos, score alpha, const score beta, const int ply) {
+    m_info.searched_nodes.fetch_add(1, std::memory_order_relaxed);
 
     if (m_info.stopped)
         return 0;
@@ -152,35 +320,50 @@ score searcher::qsearch(const board::position& pos, score alpha, const score bet
     if (!pv_node && tt_score != constants::score_none && entry.can_use_score(alpha, beta))
         return tt_score;
 
-    const score static_eval = eval::evaluate(pos);
+    const bool in_check = !pos.checkers().empty();
 
     if (ply >= constants::max_ply)
-        return static_eval;
+        return eval::evaluate(pos, &m_pawn_table);
 
-    if (static_eval >= beta)
-        return static_eval;
+    score best_score;
 
-    if (static_eval > alpha)
-        alpha = static_eval;
+    // When in check there is no stand pat, since standing still is not an option: All the
+    // evasions are searched instead, and checkmates are detected
+    if (in_check)
+        best_score = -constants::score_infinite;
+    else {
+        const score static_eval = eval::evaluate(pos, &m_pawn_table);
 
-    score best_score = static_eval;
-    auto  best_move  = moves::move::null();
+        if (static_eval >= beta)
+            return static_eval;
+
+        if (static_eval > alpha)
+            alpha = static_eval;
 
-    moves::move_list move_list;
-    generate_all_captures(pos, move_list);
-    move_list.score_moves(tt_move, pos, m_data, ply);
-    move_list.sort();
+        best_score = static_eval;
+    }
 
-    for (usize i = 0; i < move_list.size(); i++) {
-        const auto current_move = move_list.move_at(i);
+    u16  legal_moves{};
+    auto best_move = moves::move::null();
 
-        auto copy = pos;
-        copy.make_move<true>(current_move);
+    moves::move_picker move_picker(pos, tt_move, m_data, ply, true);
+    moves::move        current_move;
 
-        if (!copy.was_legal())
+    while ((current_move = move_picker.next()) != moves::move::null()) {
+        // SEE pruning: Captures that lose material are very unlikely to raise alpha
+        if (!in_check && !moves::see(pos, current_move, 0))
             continue;
 
-        const score current_score = -qsearch<pv_node>(copy, -beta, -alpha, ply + 1);
+        ++legal_moves;
+
+        // The child position probes the table right away, so its bucket is loaded while the
+        // move is being made
+        tt::global_tt.prefetch(pos.key_after(current_move));
+        pos.make_move(current_move);
+
+        const score current_score = -qsearch<pv_node>(pos, -beta, -alpha, ply + 1);
+
+        pos.unmake_move(current_move);
 
         if (current_score > best_score) {
             best_score = current_score;
@@ -198,6 +381,9 @@ score searcher::qsearch(const board::position& pos, score alpha, const score bet
             return 0;
     }
 
+    if (in_check && !legal_moves)
+        return -constants::score_mate + ply;
+
     const auto tt_flag = best_score >= beta ? tt::tt_entry::tt_flag::lower_bound
                                             : tt::tt_entry::tt_flag::upper_bound;
 
@@ -208,13 +394,13 @@ score searcher::qsearch(const board::position& pos, score alpha, const score bet
 }
 
 template <bool pv_node>
-score searcher::negamax(const board::position& pos,
-                        score                  alpha,
-                        const score            beta,
-                        const int              depth,
-                        const int              ply,
-                        pv_line&               pv) {
-    ++m_info.searched_nodes;
+score searcher::negamax(board::position& pos,
+                        score            alpha,
+                        const score      beta,
+                        const int        depth,
+                        const int        ply,
+                        pv_line&         pv) {
+    m_info.searched_nodes.fetch_add(1, std::memory_order_relaxed);
 
     if (m_info.stopped)
         return 0;
@@ -248,7 +434,7 @@ score searcher::negamax(const board::position& pos,
 
     pv_line child_pv;
 
-    const score static_eval = eval::evaluate(pos);
+    const score static_eval = eval::evaluate(pos, &m_pawn_table);
     const bool  in_check    = pos.checkers().bit_count() > 0;
 
     if (!in_check && !pv_node) {
@@ -264,11 +450,12 @@ score searcher::negamax(const board::position& pos,
             && static_eval >= beta) {
             const int r = heuristics::nmp_base_reduction + depth / heuristics::nmp_base_reduction;
 
-            auto copy = pos;
-            copy.make_null_move();
+            pos.make_null_move();
 
             const score null_move_score =
-                -negamax<false>(copy, -beta, -beta + 1, depth - r, ply + 1, child_pv);
+                -negamax<false>(pos, -beta, -beta + 1, depth - r, ply + 1, child_pv);
+
+            pos.unmake_null_move();
 
             if (null_move_score >= beta)
                 return null_move_score;
@@ -283,19 +470,26 @@ score searcher::negamax(const board::position& pos,
     auto        best_move      = moves::move::null();
     const score original_alpha = alpha;
 
-    moves::move_list move_list;
-    generate_all_moves(pos, move_list);
-    move_list.score_moves(tt_move, pos, m_data, ply);
-    move_list.sort();
+    moves::move_picker move_picker(pos, tt_move, m_data, ply, false);
+    moves::move        current_move;
+    usize              root_index = m_pv_index;
 
-    for (usize i = 0; i < move_list.size(); ++i) {
-        const auto current_move = move_list.move_at(i);
+    // The root moves are searched in the order of the previous iteration, skipping the best
+    // moves of the previous lines (MultiPV)
+    auto next_move = [&] {
+        if (!root_node)
+            return move_picker.next();
 
-        auto copy = pos;
-        copy.make_move<true>(current_move);
+        return root_index < m_root_moves.size() ? m_root_moves[root_index++].move
+                                                : moves::move::null();
+    };
 
-        if (!copy.was_legal())
-            continue;
+    while ((current_move = next_move()) != moves::move::null()) {
+        root_move* current_root_move = root_node ? &m_root_moves[root_index - 1] : nullptr;
+        const u64  nodes_before      = searched_nodes();
+
+        tt::global_tt.prefetch(pos.key_after(current_move));
+        pos.make_move(current_move);
 
         ++legal_moves;
 
@@ -306,7 +500,7 @@ score searcher::negamax(const board::position& pos,
 
         // Search the first move with a full window
         if (legal_moves == 1)
-            current_score = -negamax<pv_node>(copy, -beta, -alpha, depth - 1, ply + 1, child_pv);
+            current_score = -negamax<pv_node>(pos, -beta, -alpha, depth - 1, ply + 1, child_pv);
         else {
             // Apply LMR: Search moves that are late in move ordering with reduced depth
             const auto reduction = depth > heuristics::lmr_min_depth
@@ -321,16 +515,32 @@ score searcher::negamax(const board::position& pos,
 
             // Perform a null window search at reduced depth
             current_score =
-                -negamax<false>(copy, -alpha - 1, -alpha, reduced_depth, ply + 1, child_pv);
+                -negamax<false>(pos, -alpha - 1, -alpha, reduced_depth, ply + 1, child_pv);
 
             // Full depth search
             if (current_score > alpha && reduced_depth < new_depth)
                 current_score =
-                    -negamax<false>(copy, -alpha - 1, -alpha, new_depth, ply + 1, child_pv);
+                    -negamax<false>(pos, -alpha - 1, -alpha, new_depth, ply + 1, child_pv);
 
             // If we found a better move, do a full window search
             if (current_score > alpha && pv_node)
-                current_score = -negamax<true>(copy, -beta, -alpha, new_depth, ply + 1, child_pv);
+                current_score = -negamax<true>(pos, -beta, -alpha, new_depth, ply + 1, child_pv);
+        }
+
+        pos.unmake_move(current_move);
+
+        // Root moves keep their score and line, to report them and to sort them for the next
+        // lines. Moves that fail low only have an upper bound, so they are sorted last
+        if (root_node)
+            current_root_move->nodes += searched_nodes() - nodes_before;
+
+        if (root_node && !m_info.stopped) {
+            if (legal_moves == 1 || current_score > alpha) {
+                current_root_move->current_score = current_score;
+                current_root_move->pv.update(current_move, child_pv);
+            }
+            else
+                current_root_move->current_score = -constants::score_infinite;
         }
 
         if (current_score > best_score) {
@@ -367,31 +577,46 @@ score searcher::negamax(const board::position& pos,
                        : best_score >= beta           ? tt::tt_entry::tt_flag::lower_bound
                                                       : tt::tt_entry::tt_flag::exact;
 
-    tt::global_tt.store(pos.key(), tt::tt_entry(pos.key(), best_move,
-                                                tt::score_to_tt(best_score, ply), depth, tt_flag));
+    // The secondary lines exclude the best root moves, and so do searches restricted to some
+    // moves (go searchmoves), so their result is not the one of the root position
+    if (!root_node || (m_pv_index == 0 && m_pool.search_moves().empty()))
+        tt::global_tt.store(pos.key(),
+                            tt::tt_entry(pos.key(), best_move, tt::score_to_tt(best_score, ply),
+                                         depth, tt_flag));
 
     return best_score;
 }
 
 bool searcher::should_stop() const {
-    if (m_info.searched_nodes % 1024 != 0)
+    if (m_pool.stop_requested())
+        return true;
+
+    // Only the main thread checks the search limits, helpers just wait for it to stop them
+    if (!is_main_thread() || searched_nodes() % 1024 != 0)
         return false;
 
     const u64 elapsed = m_timer.elapsed();
 
-    return m_info.searched_nodes >= m_limits.nodes_limit || elapsed >= m_limits.time_limit
-        || elapsed >= m_timer.optimum_time();
+    return m_pool.searched_nodes() >= m_limits.nodes_limit || elapsed >= m_limits.time_limit
+        || elapsed >= m_timer.hard_limit();
 }
 
-void searcher::report_info(const u64      elapsed,
-                           const int      depth,
-                           const score    score,
-                           const pv_line& pv) const {
-    std::cout << std::format("info depth {} score {} time {} nodes {} nps {} hashfull {} pv{}",
-                             depth, utils::score::to_string(score), elapsed, m_info.searched_nodes,
-                             m_info.searched_nodes / std::max<u64>(1, elapsed) * 1000,
-                             tt::global_tt.hashfull(), pv.to_string())
-              << std::endl;
+void searcher::report_info(const u64         elapsed,
+                           const int         depth,
+                           const usize       pv_index,
+                           const score       score,
+                           const pv_line&    pv,
+                           const score_bound bound) const {
+    const u64 total_nodes = m_pool.searched_nodes();
+
+    const auto bound_string = bound == score_bound::lower ? " lowerbound"
+                            : bound == score_bound::upper ? " upperbound"
+                                                          : "";
+
+    utils::io::print_line(std::format(
+        "info depth {} multipv {} score {}{} time {} nodes {} nps {} hashfull {} pv{}", depth,
+        pv_index + 1, utils::score::to_string(score), bound_string, elapsed, total_nodes,
+        total_nodes / std::max<u64>(1, elapsed) * 1000, tt::global_tt.hashfull(), pv.to_string()));
 }
 
 } // namespace search
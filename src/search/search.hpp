@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <format>
 #include <vector>
@@ -8,6 +9,8 @@
 #include "../timeman.hpp"
 
 #include "../board/position.hpp"
+#include "../eval/nnue.hpp"
+#include "../eval/pawns.hpp"
 #include "../utils/mdarray.hpp"
 
 namespace search {
@@ -50,6 +53,24 @@ struct pv_line {
         }
 };
 
+/// @brief Move of the root position, with the score and principal variation of its last search
+struct root_move {
+        moves::move move;
+        score       current_score{-constants::score_infinite};
+        score       previous_score{-constants::score_infinite};
+        pv_line     pv{};
+
+        /// @brief Nodes searched in the subtree of the move, during the whole search
+        u64 nodes{};
+};
+
+/// @brief Whether a reported score is exact or only a bound, after failing high or low
+enum class score_bound : u8 {
+    exact,
+    lower,
+    upper
+};
+
 struct search_limits {
         u64 nodes_limit;
         u64 time_limit;
@@ -57,9 +78,9 @@ struct search_limits {
 };
 
 struct search_info {
-        u64     searched_nodes;
-        pv_line pv;
-        bool    stopped;
+        std::atomic<u64> searched_nodes;
+        pv_line          pv;
+        bool             stopped;
 };
 
 struct search_data {
@@ -103,9 +124,21 @@ struct search_data {
         }
 };
 
+class thread_pool;
+
 class searcher {
     public:
-        [[nodiscard]] u64 searched_nodes() const { return m_info.searched_nodes; }
+        searcher(const usize thread_id, thread_pool& pool) :
+            m_thread_id(thread_id),
+            m_pool(pool) {}
+
+        [[nodiscard]] u64 searched_nodes() const {
+            return m_info.searched_nodes.load(std::memory_order_relaxed);
+        }
+
+        /// @brief The main thread is the only one that checks the search limits, reports info
+        /// and decides the best move. The rest of threads are helpers (Lazy SMP)
+        [[nodiscard]] bool is_main_thread() const { return m_thread_id == 0; }
 
         void reset();
         void set_limits(u64 nodes_limit, u64 time_limit, u32 depth_limit);
@@ -114,13 +147,28 @@ class searcher {
 
         /// @brief Main entrypoint for the search function
         /// @param pos Position to search from
-        void main_search(const board::position& pos);
+        /// @returns The best move found by this thread
+        moves::move main_search(const board::position& pos);
 
     private:
-        search_data   m_data;
-        search_info   m_info{};
-        search_limits m_limits{};
-        time_manager  m_timer{};
+        usize                         m_thread_id;
+        thread_pool&                  m_pool;
+        search_data                   m_data;
+        search_info                   m_info{};
+        search_limits                 m_limits{};
+        time_manager                  m_timer{};
+        eval::nnue::accumulator_stack m_accumulators;
+        eval::pawns::pawn_table       m_pawn_table;
+        std::vector<root_move>        m_root_moves;
+        usize                         m_pv_index{};
+
+        /// @brief Searches the root with a narrow window around the score of the previous
+        /// iteration, widening it every time the score falls outside
+        /// @param root_pos Position to search from
+        /// @param depth Depth of the iteration
+        /// @param previous_score Best score of the previous iteration
+        /// @returns The best score found
+        score aspiration_search(board::position& root_pos, int depth, score previous_score);
 
         /// @brief Quiescence search, to get rid of the horizon effect
         /// @tparam pv_node Indicates if the current node is from the principal variation
@@ -131,7 +179,7 @@ class searcher {
         /// @returns The best score found
         /// @note See https://en.wikipedia.org/wiki/Quiescence_search for reference
         template <bool pv_node>
-        score qsearch(const board::position& pos, score alpha, score beta, int ply);
+        score qsearch(board::position& pos, score alpha, score beta, int ply);
 
         /// @brief Fail-soft negamax algorithm with alpha-beta pruning
         /// @tparam pv_node Indicates if the current node is from the principal variation
@@ -145,18 +193,25 @@ class searcher {
         /// @note See https://en.wikipedia.org/wiki/Negamax for reference
         template <bool pv_node>
         score negamax(
-            const board::position& pos, score alpha, score beta, int depth, int ply, pv_line& pv);
+            board::position& pos, score alpha, score beta, int depth, int ply, pv_line& pv);
 
         /// @brief Determines if search should stop according to the search limits
-        /// @returns true if time is up or the nodes or time limit is exceeded
+        /// @returns true if a stop was requested, time is up or the nodes or time limit is exceeded
         [[nodiscard]] bool should_stop() const;
 
         /// @brief Reports uci-compliant info about the search tree
         /// @param elapsed Elapsed time since the start of the search, in milliseconds
         /// @param depth Depth of the search tree
+        /// @param pv_index Index of the reported line (MultiPV), starting from 0
         /// @param score Score of the current position
         /// @param pv Principal variation line from the current position
-        void report_info(u64 elapsed, int depth, score score, const pv_line& pv) const;
+        /// @param bound Whether the score is exact or a bound of a failed aspiration window
+        void report_info(u64            elapsed,
+                         int            depth,
+                         usize          pv_index,
+                         score          score,
+                         const pv_line& pv,
+                         score_bound    bound = score_bound::exact) const;
 };
 
 } // namespace search
\ No newline at end of file
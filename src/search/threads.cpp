@@ -0,0 +1,87 @@
+#include "threads.hpp"
+
+#include <format>
+#include <limits>
+
+#include "tt.hpp"
+
+#include "../utils/io.hpp"
+
+namespace search {
+
+void thread_pool::resize(const usize thread_count) {
+    m_searchers.clear();
+
+    for (usize i = 0; i < thread_count; ++i) {
+        m_searchers.push_back(std::make_unique<searcher>(i, *this));
+
+        // Helpers are not limited, they keep searching until the main thread stops them
+        if (i != 0)
+            m_searchers.back()->set_limits(std::numeric_limits<u64>::max(),
+                                           std::numeric_limits<u64>::max(), constants::max_depth);
+    }
+}
+
+void thread_pool::set_limits(const u64 nodes_limit, const u64 time_limit, const u32 depth_limit) {
+    main_thread().set_limits(nodes_limit, time_limit, depth_limit);
+}
+
+void thread_pool::set_start_time(const u64 time) { main_thread().set_start_time(time); }
+
+void thread_pool::parse_time_control(const std::vector<std::string>& command, const color stm) {
+    main_thread().parse_time_control(command, stm);
+}
+
+void thread_pool::start_search(const board::position& pos, const bool infinite) {
+    wait();
+
+    m_stop.store(false, std::memory_order_relaxed);
+
+    for (const auto& searcher : m_searchers)
+        searcher->reset();
+
+    tt::global_tt.new_search();
+
+    m_main = std::thread([this, pos, infinite] { search(pos, infinite); });
+}
+
+void thread_pool::stop() {
+    m_stop.store(true, std::memory_order_relaxed);
+    m_stop.notify_all();
+}
+
+void thread_pool::wait() {
+    if (m_main.joinable())
+        m_main.join();
+}
+
+void thread_pool::search(const board::position& pos, const bool infinite) {
+    for (usize i = 1; i < size(); ++i)
+        m_helpers.emplace_back([this, i, pos] { m_searchers[i]->main_search(pos); });
+
+    const auto best_move = main_thread().main_search(pos);
+
+    // In infinite mode the best move can't be sent before the GUI tells us to stop
+    if (infinite)
+        m_stop.wait(false, std::memory_order_relaxed);
+
+    m_stop.store(true, std::memory_order_relaxed);
+
+    for (auto& helper : m_helpers)
+        helper.join();
+
+    m_helpers.clear();
+
+    utils::io::print_line(std::format("bestmove {}", best_move.to_string()));
+}
+
+u64 thread_pool::searched_nodes() const {
+    u64 total_nodes{};
+
+    for (const auto& searcher : m_searchers)
+        total_nodes += searcher->searched_nodes();
+
+    return total_nodes;
+}
+
+} // namespace search
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "search.hpp"
+
+namespace search {
+
+/// @class thread_pool
+/// @brief Owns every searcher and runs them in parallel following the Lazy SMP approach: all
+/// threads search the same position sharing the transposition table, while the main thread is
+/// the one reporting info and deciding the best move
+/// @note See https://www.chessprogramming.org/Lazy_SMP for reference
+class thread_pool {
+    public:
+        static constexpr usize max_threads  = 256;
+        static constexpr usize max_multi_pv = constants::max_moves;
+
+        static constexpr u64 default_move_overhead = 10;
+        static constexpr u64 max_move_overhead     = 5000;
+
+        thread_pool() { resize(1); }
+
+        ~thread_pool() {
+            stop();
+            wait();
+        }
+
+        /// @brief Sets the number of threads used during search
+        /// @param thread_count Number of threads, including the main thread
+        void resize(usize thread_count);
+
+        void set_limits(u64 nodes_limit, u64 time_limit, u32 depth_limit);
+        void set_start_time(u64 time);
+        void parse_time_control(const std::vector<std::string>& command, color stm);
+
+        /// @brief Sets the number of best lines the main thread searches and reports (MultiPV)
+        void set_multi_pv(const usize multi_pv) { m_multi_pv = multi_pv; }
+
+        [[nodiscard]] usize multi_pv() const { return m_multi_pv; }
+
+        /// @brief Sets the time reserved for the communication with the GUI on every move
+        void set_move_overhead(const u64 move_overhead) { m_move_overhead = move_overhead; }
+
+        [[nodiscard]] u64 move_overhead() const { return m_move_overhead; }
+
+        /// @brief Restricts the root moves of the next search (go searchmoves)
+        /// @param search_moves Moves to search, or an empty list to search all of them
+        void set_search_moves(const std::vector<moves::move>& search_moves) {
+            m_search_moves = search_moves;
+        }
+
+        [[nodiscard]] const std::vector<moves::move>& search_moves() const {
+            return m_search_moves;
+        }
+
+        /// @brief Starts searching the position in the background with all the threads. The best
+        /// move found by the main thread is printed once every thread has finished
+        /// @param pos Position to search from
+        /// @param infinite If true, the best move is not printed until a stop is requested
+        void start_search(const board::position& pos, bool infinite);
+
+        /// @brief Requests all the threads to stop searching as soon as possible
+        void stop();
+
+        /// @brief Blocks until the current search (if any) has finished
+        void wait();
+
+        [[nodiscard]] bool stop_requested() const { return m_stop.load(std::memory_order_relaxed); }
+
+        /// @brief Sums the nodes searched by all the threads
+        /// @returns The total number of searched nodes
+        [[nodiscard]] u64 searched_nodes() const;
+
+        [[nodiscard]] usize size() const { return m_searchers.size(); }
+
+    private:
+        [[nodiscard]] searcher& main_thread() { return *m_searchers.front(); }
+
+        /// @brief Body of the background search thread, which drives the main searcher and the
+        /// helpers
+        void search(const board::position& pos, bool infinite);
+
+        std::vector<std::unique_ptr<searcher>> m_searchers;
+        std::vector<std::thread>               m_helpers;
+        std::thread                            m_main;
+        std::atomic<bool>                      m_stop{false};
+        usize                                  m_multi_pv{1};
+        u64                                    m_move_overhead{default_move_overhead};
+        std::vector<moves::move>               m_search_moves;
+};
+
+} // namespace search
@@ -1,47 +1,251 @@
 #include "tt.hpp"
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../utils/memory.hpp"
 
 namespace search::tt {
 
+namespace {
+
+/// @brief Loads the entry of the slot
+/// @returns false if the slot is empty or holds another position
+bool load_entry(tt_slot& slot, const zobrist_key key, tt_entry& entry) {
+    entry           = std::atomic_ref(slot.entry).load(std::memory_order_relaxed);
+    const u64 check = std::atomic_ref(slot.check).load(std::memory_order_relaxed);
+
+    return !entry.empty() && entry.key_matches(key) && (check ^ std::bit_cast<u64>(entry)) == key;
+}
+
+void store_entry(tt_slot& slot, const zobrist_key key, const tt_entry& entry) {
+    std::atomic_ref(slot.check).store(key ^ std::bit_cast<u64>(entry), std::memory_order_relaxed);
+    std::atomic_ref(slot.entry).store(entry, std::memory_order_relaxed);
+}
+
+} // namespace
+
 bool transposition_table::probe(const zobrist_key key, tt_entry& entry) const {
-    if (const auto current_entry = m_data[index(key)]; current_entry.key_matches(key)) {
-        entry = current_entry;
+    if (empty())
+        return false;
+
+    for (auto& slot : m_data[index(key)].slots) {
+        if (tt_entry loaded_entry; load_entry(slot, key, loaded_entry)) {
+            entry = loaded_entry;
 
-        return true;
+            return true;
+        }
     }
 
     return false;
 }
 
-void transposition_table::clear() { std::ranges::fill(m_data, tt_entry{}); }
+transposition_table::~transposition_table() { utils::memory::free_huge_pages(m_data); }
 
-void transposition_table::resize(const usize size_mb) {
+void transposition_table::clear(const usize thread_count) {
+    // Each thread clears a contiguous chunk of the table. With large tables this is also the
+    // first time the memory is touched, so page faults are spread across threads as well
+    const usize chunk_size = (m_bucket_count + thread_count - 1) / thread_count;
+
+    auto clear_chunk = [this, chunk_size](const usize thread_id) {
+        const usize begin = std::min(thread_id * chunk_size, m_bucket_count);
+        const usize end   = std::min(begin + chunk_size, m_bucket_count);
+
+        std::uninitialized_fill(m_data + begin, m_data + end, tt_bucket{});
+    };
+
+    std::vector<std::thread> helpers;
+
+    for (usize i = 1; i < thread_count; ++i)
+        helpers.emplace_back(clear_chunk, i);
+
+    clear_chunk(0);
+
+    for (auto& helper : helpers)
+        helper.join();
+
+    m_age = 0;
+}
+
+bool transposition_table::resize(const usize size_mb, const usize thread_count) {
     constexpr usize bytes_per_mb = 1024 * 1024;
-    const usize     entry_count  = (size_mb * bytes_per_mb) / sizeof(tt_entry);
 
-    m_data.resize(entry_count);
-    clear();
+    const usize previous_bucket_count = m_bucket_count;
+
+    // The current table is released first, so that the peak memory usage is not the sum of both
+    // tables when resizing huge ones
+    utils::memory::free_huge_pages(m_data);
+
+    m_bucket_count = (size_mb * bytes_per_mb) / sizeof(tt_bucket);
+    m_data         = static_cast<tt_bucket*>(
+        utils::memory::alloc_huge_pages(m_bucket_count * sizeof(tt_bucket)));
+
+    const bool allocated = m_data != nullptr;
+
+    // Fall back to the previous size if there is not enough memory, and to the minimum size if
+    // not even that can be allocated
+    const std::array fallback_bucket_counts = {previous_bucket_count,
+                                               min_tt_size * bytes_per_mb / sizeof(tt_bucket)};
+
+    for (auto it = fallback_bucket_counts.begin(); m_data == nullptr; ++it) {
+        // Without any memory left, the table stays empty and every probe misses
+        if (it == fallback_bucket_counts.end()) {
+            m_bucket_count = 0;
+            m_age          = 0;
+
+            return false;
+        }
+
+        if (*it == 0)
+            continue;
+
+        m_bucket_count = *it;
+        m_data         = static_cast<tt_bucket*>(
+            utils::memory::alloc_huge_pages(m_bucket_count * sizeof(tt_bucket)));
+    }
+
+    clear(thread_count);
+
+    return allocated;
+}
+
+bool transposition_table::save(const std::string& path) const {
+    if (empty())
+        return false;
+
+    std::ofstream file(path, std::ios::binary);
+
+    if (!file)
+        return false;
+
+    const file_header header{file_magic, file_version, sizeof(tt_bucket), m_bucket_count, m_age};
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_data),
+               static_cast<std::streamsize>(m_bucket_count * sizeof(tt_bucket)));
+
+    return static_cast<bool>(file);
+}
+
+bool transposition_table::load(const std::string& path, const usize thread_count) {
+    constexpr usize bytes_per_mb = 1024 * 1024;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+    if (!file)
+        return false;
+
+    const auto  file_size = static_cast<usize>(file.tellg());
+    file_header header{};
+
+    file.seekg(0);
+
+    if (file_size < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || header.magic != file_magic || header.version != file_version
+        || header.bucket_size != sizeof(tt_bucket) || header.age >= tt_entry::age_cycle)
+        return false;
+
+    // The bucket count is bounded before computing any size from it, so that it can't overflow.
+    // Tables are always sized in whole megabytes, so the saved size maps back to the same number
+    // of buckets
+    constexpr usize buckets_per_mb = bytes_per_mb / sizeof(tt_bucket);
+
+    if (header.bucket_count == 0 || header.bucket_count > max_tt_size * buckets_per_mb
+        || header.bucket_count % buckets_per_mb != 0
+        || (file_size - sizeof(header)) / sizeof(tt_bucket) != header.bucket_count
+        || (file_size - sizeof(header)) % sizeof(tt_bucket) != 0)
+        return false;
+
+    const usize previous_size_mb = size_mb();
+
+    if (!resize(header.bucket_count / buckets_per_mb, thread_count))
+        return false;
+
+    // Go back to the configured size if the entries can't be read, so that it still matches the
+    // Hash option
+    if (!file.read(reinterpret_cast<char*>(m_data),
+                   static_cast<std::streamsize>(m_bucket_count * sizeof(tt_bucket)))) {
+        resize(previous_size_mb, thread_count);
+        return false;
+    }
+
+    m_age = static_cast<u8>(header.age);
+
+    return true;
 }
 
 void transposition_table::prefetch(const zobrist_key key) {
-    __builtin_prefetch(&m_data[index(key)]);
+    if (!empty())
+        __builtin_prefetch(&m_data[index(key)]);
 }
 
 void transposition_table::store(const zobrist_key key, const tt_entry& entry) {
-    m_data[index(key)] = entry;
+    if (empty())
+        return;
+
+    auto& bucket = m_data[index(key)];
+
+    // Other threads may write to the bucket meanwhile, so the decision is made on a snapshot of
+    // the entries. At worst, a slot overwritten in between is overwritten again
+    usize    replacement_index = 0;
+    tt_entry replacement;
+    bool     same_position = false;
+
+    for (usize i = 0; i < tt_bucket::num_entries; ++i) {
+        tt_entry current_entry;
+        same_position = load_entry(bucket.slots[i], key, current_entry);
+
+        if (current_entry.empty() || same_position) {
+            replacement_index = i;
+            replacement       = current_entry;
+            break;
+        }
+
+        if (i == 0 || replacement_value(current_entry) < replacement_value(replacement)) {
+            replacement_index = i;
+            replacement       = current_entry;
+        }
+    }
+
+    tt_entry new_entry = entry;
+
+    if (same_position) {
+        // Keep a deeper entry of the same position from the current search, unless the new one
+        // carries an exact score
+        if (entry.flag() != tt_entry::tt_flag::exact && replacement.age() == m_age
+            && entry.depth() + 4 < replacement.depth())
+            return;
+
+        // Don't lose the best move of the position if the new search failed to find one
+        if (entry.move() == moves::move::null())
+            new_entry.set_move(replacement.move());
+    }
+
+    new_entry.set_age(m_age);
+    store_entry(bucket.slots[replacement_index], key, new_entry);
 }
 
+void transposition_table::new_search() { m_age = (m_age + 1) % tt_entry::age_cycle; }
+
 u64 transposition_table::index(const zobrist_key key) const {
-    return (static_cast<u128>(key) * static_cast<u128>(m_data.size())) >> 64;
+    return (static_cast<u128>(key) * static_cast<u128>(m_bucket_count)) >> 64;
 }
 
 u16 transposition_table::hashfull() const {
     u16 hashfull{};
 
-    for (int i = 0; i < 1000; ++i) {
-        if (m_data[i].flag() != tt_entry::tt_flag::none)
-            ++hashfull;
+    for (usize i = 0; i < std::min<usize>(1000 / tt_bucket::num_entries, m_bucket_count); ++i) {
+        for (auto& slot : m_data[i].slots) {
+            const tt_entry entry = std::atomic_ref(slot.entry).load(std::memory_order_relaxed);
+
+            if (!entry.empty() && entry.age() == m_age)
+                ++hashfull;
+        }
     }
 
     return hashfull;
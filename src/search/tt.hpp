@@ -1,6 +1,9 @@
 #pragma once
 
-#include <vector>
+#include <array>
+#include <atomic>
+#include <string>
+#include <utility>
 
 #include "../moves/move.hpp"
 
@@ -9,8 +12,11 @@ namespace search::tt {
 /// @class tt_entry
 /// @brief Represents and entry of the transposition table
 /// @note For efficiency and in order to maximize the number of entries that the tranposition table
-/// can store, keys and scores are packed into 16 bits
-class tt_entry {
+/// can store, keys and scores are packed into 16 bits, while the bound type and the age of the
+/// entry share the same byte. The whole entry fits in 64 bits, so that it can be read and written
+/// atomically. 16 bits of key alone let through too many collisions, so the table also keeps the
+/// full key next to every entry (see tt_slot)
+class alignas(u64) tt_entry {
     public:
         enum class tt_flag : u8 {
             none,
@@ -19,12 +25,16 @@ class tt_entry {
             lower_bound
         };
 
+        static constexpr u8 flag_bits = 2;
+        static constexpr u8 flag_mask = (1 << flag_bits) - 1;
+        static constexpr u8 age_cycle = 1 << (8 - flag_bits);
+
         tt_entry() :
             m_key(0),
             m_move(moves::move::null()),
             m_score(constants::score_none),
             m_depth(0),
-            m_flag(tt_flag::none) {}
+            m_age_flag(std::to_underlying(tt_flag::none)) {}
 
         tt_entry(
             const zobrist_key k, const moves::move m, const score s, const u8 d, const tt_flag f) :
@@ -32,7 +42,7 @@ class tt_entry {
             m_move(m),
             m_score(static_cast<i16>(s)),
             m_depth(d),
-            m_flag(f) {}
+            m_age_flag(std::to_underlying(f)) {}
 
         [[nodiscard]] tt_key key() const { return m_key; }
 
@@ -42,19 +52,31 @@ class tt_entry {
 
         [[nodiscard]] u8 depth() const { return m_depth; }
 
-        [[nodiscard]] tt_flag flag() const { return m_flag; }
+        [[nodiscard]] tt_flag flag() const { return static_cast<tt_flag>(m_age_flag & flag_mask); }
+
+        [[nodiscard]] u8 age() const { return m_age_flag >> flag_bits; }
+
+        [[nodiscard]] bool empty() const { return flag() == tt_flag::none; }
 
         [[nodiscard]] bool key_matches(const zobrist_key key) const {
             return m_key == static_cast<tt_key>(key);
         }
 
+        void set_age(const u8 age) {
+            m_age_flag = static_cast<u8>(age << flag_bits) | (m_age_flag & flag_mask);
+        }
+
+        void set_move(const moves::move m) { m_move = m; }
+
         /// @brief Determines if the stored score in the entry can be used for search
         /// @param alpha The lower bound of the search window
         /// @param beta The upper bound of the search window
         /// @returns true if the score is exact or within the search window bounds
         [[nodiscard]] bool can_use_score(const score alpha, const score beta) const {
-            return m_flag == tt_flag::exact || (m_flag == tt_flag::upper_bound && m_score <= alpha)
-                || (m_flag == tt_flag::lower_bound && m_score >= beta);
+            const tt_flag flag = this->flag();
+
+            return flag == tt_flag::exact || (flag == tt_flag::upper_bound && m_score <= alpha)
+                || (flag == tt_flag::lower_bound && m_score >= beta);
         }
 
     private:
@@ -62,18 +84,55 @@ class tt_entry {
         moves::move m_move;
         i16         m_score;
         u8          m_depth;
-        tt_flag     m_flag;
+        u8          m_age_flag;
 };
 
 static_assert(sizeof(tt_entry) == 8);
+static_assert(std::atomic_ref<tt_entry>::is_always_lock_free);
+
+/// @brief Entry of the table along with the full key of its position, xored with the entry. A
+/// probe checks all 64 bits of the key, and an entry that was only half written by another thread
+/// doesn't match either, as it no longer hashes back to the key
+struct tt_slot {
+        u64      check{};
+        tt_entry entry{};
+};
+
+/// @brief Group of entries sharing the same index, sized and aligned to fit in a cache line
+struct alignas(64) tt_bucket {
+        static constexpr usize num_entries = 4;
 
+        std::array<tt_slot, num_entries> slots{};
+};
+
+static_assert(sizeof(tt_bucket) == 64);
+
+/// @class transposition_table
+/// @brief Hash table shared by all the search threads. It is lock-free: Entries and their checks
+/// are read and written with relaxed atomic operations, and a check only matches the entry it was
+/// written with. Entries of different positions may still be mixed up through full key
+/// collisions, so the stored moves must be validated before being played
 class transposition_table {
     public:
+        /// @brief Default size for the tranposition table, in MB
+        static constexpr usize default_tt_size = 16;
+
+        /// @brief Minimum size for the transposition table, in MB
+        static constexpr usize min_tt_size = 1;
+
+        /// @brief Maximum size for the transposition table, in MB (256 GB)
+        static constexpr usize max_tt_size = 262144;
+
         transposition_table() :
             transposition_table(default_tt_size) {}
 
         explicit transposition_table(const usize size) { resize(size); }
 
+        ~transposition_table();
+
+        transposition_table(const transposition_table&)            = delete;
+        transposition_table& operator=(const transposition_table&) = delete;
+
         /// @brief Checks if the position has been saved already in the tranposition table
         /// @param key Zobrist key
         /// @param entry Entry to fill if position is found
@@ -81,28 +140,77 @@ class transposition_table {
         bool probe(zobrist_key key, tt_entry& entry) const;
 
         /// @brief Clears the transposition table by filling it with default-initialized entries
-        void clear();
+        /// @param thread_count Number of threads the work is split across
+        void clear(usize thread_count = 1);
 
-        /// @brief Sets the size of the transposition table accordingly
+        /// @brief Sets the size of the transposition table accordingly. Memory is aligned to huge
+        /// pages and cleared right away
         /// @param size_mb Memory to allocate, in MB
-        void resize(usize size_mb);
-
-        /// @brief Prefetches and entry of the tranposition table
+        /// @param thread_count Number of threads used to clear the new table
+        /// @returns false if there is not enough memory, in which case the table keeps its
+        /// previous size. If not even that can be allocated, the minimum size is tried, and the
+        /// table is left empty (see empty()) if that fails too
+        bool resize(usize size_mb, usize thread_count = 1);
+
+        /// @brief Writes the whole table to a file, preceded by a small header, so that it can be
+        /// loaded back later to resume the analysis with the same entries
+        /// @param path Path of the file to write
+        /// @returns false if the file could not be written
+        /// @note Must not be called while searching
+        bool save(const std::string& path) const;
+
+        /// @brief Replaces the table with one previously saved to a file, resizing it to the size
+        /// it had when it was saved
+        /// @param path Path of the file to read
+        /// @param thread_count Number of threads used to clear the table when resizing
+        /// @returns false if the file is missing, corrupt, larger than the maximum size or was
+        /// written by an incompatible version, in which case the table is left untouched. Also
+        /// false if there is not enough memory or the file can't be read completely, in which
+        /// case the table is cleared, keeping its previous size
+        /// @note Must not be called while searching
+        bool load(const std::string& path, usize thread_count = 1);
+
+        /// @brief Prefetches the bucket of the tranposition table where the key is mapped to
         /// @param key Zobrist key
         void prefetch(zobrist_key key);
 
-        /// @brief Stores an entry in the transposition table
+        /// @brief Stores an entry in the transposition table. Inside the bucket, the entry for the
+        /// same position is replaced if present. Otherwise, the least valuable entry is replaced
         /// @param key Zobrist key
         /// @param entry Entry to store
         void store(zobrist_key key, const tt_entry& entry);
 
+        /// @brief Increases the age of the table, so that entries from previous searches are
+        /// replaced first. Must be called before every new search
+        void new_search();
+
+        /// @brief Checks if the table has no memory at all, which only happens if every allocation
+        /// failed. An empty table never finds nor stores anything
+        [[nodiscard]] bool empty() const { return m_bucket_count == 0; }
+
+        /// @returns The size of the transposition table, in MB
+        [[nodiscard]] usize size_mb() const {
+            return m_bucket_count * sizeof(tt_bucket) / (1024 * 1024);
+        }
+
         /// @brief Gives an estimate of how much entries are filled in the transposition table
-        /// @returns The number of filled entries, in the range [0, 1000]
+        /// @returns The number of filled entries from the current search, in the range [0, 1000]
         [[nodiscard]] u16 hashfull() const;
 
     private:
-        /// @brief Default size for the tranposition table, in MB
-        static constexpr usize default_tt_size = 16;
+        /// @brief Header of the files the table is saved to
+        struct file_header {
+                u64 magic;
+                u32 version;
+                u32 bucket_size;
+                u64 bucket_count;
+                u64 age;
+        };
+
+        static constexpr u64 file_magic = 0x4853414858525942ULL; // "BYRXHASH"
+
+        /// @brief Version of the layout of the entries, to be increased every time it changes
+        static constexpr u32 file_version = 2;
 
         /// @brief Creates an index to map the tranposition table using the "fast range" trick
         /// @param key Zobrist key
@@ -110,7 +218,21 @@ class transposition_table {
         /// @returns The computed 64-bit index
         [[nodiscard]] u64 index(zobrist_key key) const;
 
-        std::vector<tt_entry> m_data;
+        /// @brief Number of searches since the entry was stored, wrapped to the age cycle
+        [[nodiscard]] u8 relative_age(const tt_entry& entry) const {
+            return (tt_entry::age_cycle + m_age - entry.age()) % tt_entry::age_cycle;
+        }
+
+        /// @brief Worth of keeping an entry in the table. Deep entries, exact bounds and entries
+        /// from the current search are preferred
+        [[nodiscard]] int replacement_value(const tt_entry& entry) const {
+            return entry.depth() + 2 * (entry.flag() == tt_entry::tt_flag::exact)
+                 - 8 * relative_age(entry);
+        }
+
+        tt_bucket* m_data{};
+        usize      m_bucket_count{};
+        u8         m_age{};
 };
 
 /// @brief Adjusts the score before storing it in the transposition table
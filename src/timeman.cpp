@@ -1,9 +1,58 @@
 #include "timeman.hpp"
 
+#include <algorithm>
+#include <array>
+
 #include "utils/time.hpp"
 
+namespace {
+
+/// @brief Soft limit scale, indexed by the consecutive iterations the best move has stayed the
+/// same
+constexpr std::array best_move_stability_scale = {2.20, 1.30, 1.00, 0.85, 0.75};
+
+/// @brief The soft limit is scaled by (base - fraction) * multiplier, where the fraction is the
+/// share of the nodes spent on the best move. It ranges from 2.03 (no nodes) to 0.68 (all nodes)
+constexpr double node_fraction_base       = 1.50;
+constexpr double node_fraction_multiplier = 1.35;
+
+} // namespace
+
+time_manager::time_manager(const u64 start_time,
+                           const u64 time_left,
+                           const u64 increment,
+                           const u16 moves_to_go,
+                           const u64 move_overhead) :
+    m_start_time(start_time) {
+    // Keep at least some time to search, even if the clock is almost empty
+    const u64 available = std::max<u64>(time_left - std::min(time_left, move_overhead), 1);
+    const u64 moves     = moves_to_go > 0 ? std::min<u16>(moves_to_go, 50) : default_moves_to_go;
+
+    m_hard_limit        = std::max<u64>(std::min(available * 3 / 4, available / moves * 5), 1);
+    m_soft_limit        = std::min(available / moves + increment / 2, m_hard_limit);
+    m_scaled_soft_limit = m_soft_limit;
+}
+
 void time_manager::set_start_time(const u64 start_time) { m_start_time = start_time; }
 
 u64 time_manager::elapsed() const { return utils::time::get_time_ms() - m_start_time; }
 
-u64 time_manager::optimum_time() const { return m_base_time / 20 + m_increment / 2; }
+void time_manager::scale_soft_limit(const int    best_move_stability,
+                                    const score  score_drop,
+                                    const double best_move_node_fraction) {
+    // Searches without a clock have no limits to scale
+    if (m_soft_limit == std::numeric_limits<u64>::max())
+        return;
+
+    const double stability_scale =
+        best_move_stability_scale[std::min<usize>(best_move_stability,
+                                                  best_move_stability_scale.size() - 1)];
+    const double score_scale = std::clamp(1.0 + score_drop / 100.0, 0.85, 1.50);
+    const double node_scale =
+        (node_fraction_base - std::clamp(best_move_node_fraction, 0.0, 1.0))
+        * node_fraction_multiplier;
+
+    m_scaled_soft_limit = std::min(static_cast<u64>(static_cast<double>(m_soft_limit)
+                                                    * stability_scale * score_scale * node_scale),
+                                   m_hard_limit);
+}
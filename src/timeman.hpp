@@ -1,27 +1,56 @@
 #pragma once
 
+#include <limits>
+
 #include "types.hpp"
 
+/// @class time_manager
+/// @brief Splits the remaining clock time into two limits: the soft one, after which no new
+/// iteration is started, and the hard one, after which the search is aborted. The soft limit is
+/// scaled after every iteration depending on how settled the search looks
 class time_manager {
     public:
+        /// @brief Moves to go assumed when the time control doesn't specify them
+        static constexpr u16 default_moves_to_go = 20;
+
+        /// @brief Time manager without a clock, whose limits are never reached
         time_manager() :
-            m_start_time(0),
-            m_base_time(UINT64_MAX),
-            m_increment(UINT16_MAX) {}
+            m_start_time(0) {}
 
-        time_manager(const u64 start_time, const u64 base_time, const u16 increment) {
-            this->m_start_time = start_time;
-            this->m_base_time  = base_time;
-            this->m_increment  = increment;
-        }
+        /// @param start_time Time the search started at, in milliseconds
+        /// @param time_left Remaining time of the side to move, in milliseconds
+        /// @param increment Increment per move, in milliseconds
+        /// @param moves_to_go Moves until the next time control, or 0 if there is none
+        /// @param move_overhead Time reserved for the communication with the GUI, in milliseconds
+        time_manager(u64 start_time,
+                     u64 time_left,
+                     u64 increment,
+                     u16 moves_to_go,
+                     u64 move_overhead);
 
         void set_start_time(u64 start_time);
 
         [[nodiscard]] u64 elapsed() const;
-        [[nodiscard]] u64 optimum_time() const;
+
+        [[nodiscard]] u64 soft_limit() const { return m_scaled_soft_limit; }
+        [[nodiscard]] u64 hard_limit() const { return m_hard_limit; }
+
+        /// @brief Scales the soft limit after an iteration: More time is used when the best move
+        /// keeps changing, the score drops or the alternatives take a lot of effort to refute, and
+        /// less when the search is stable
+        /// @param best_move_stability Consecutive iterations the best move has stayed the same
+        /// @param score_drop Score of the previous iteration minus the current one
+        /// @param best_move_node_fraction Fraction of the searched nodes spent on the best move
+        void scale_soft_limit(int    best_move_stability,
+                              score  score_drop,
+                              double best_move_node_fraction);
+
+        /// @brief Checks whether a new iteration should not be started
+        [[nodiscard]] bool soft_limit_reached() const { return elapsed() >= m_scaled_soft_limit; }
 
     private:
         u64 m_start_time;
-        u64 m_base_time;
-        u16 m_increment;
-};
\ No newline at end of file
+        u64 m_soft_limit{std::numeric_limits<u64>::max()};
+        u64 m_scaled_soft_limit{std::numeric_limits<u64>::max()};
+        u64 m_hard_limit{std::numeric_limits<u64>::max()};
+};
@@ -1,15 +1,18 @@
 #include "uci.hpp"
 
+#include <algorithm>
 #include <format>
 #include <iostream>
 #include <limits>
 #include <numeric>
 
 #include "../eval/eval.hpp"
+#include "../eval/nnue.hpp"
 #include "../moves/movegen.hpp"
 #include "../perft/perft.hpp"
 #include "../utils/split.hpp"
 #include "../search/tt.hpp"
+#include "../utils/io.hpp"
 #include "../utils/parsing.hpp"
 #include "../utils/time.hpp"
 
@@ -18,47 +21,82 @@ namespace uci {
 void command_handler::handle_d(const board::position& pos) { print_board(pos); }
 
 void command_handler::handle_eval(const board::position& pos) {
-    std::cout << std::format("\nStatic evaluation: {}", eval::evaluate(pos)) << std::endl;
+    utils::io::print_line(std::format("\nStatic evaluation: {}", eval::evaluate(pos)));
 }
 
-void command_handler::handle_is_ready() { std::cout << "readyok" << std::endl; }
+void command_handler::handle_is_ready() { utils::io::print_line("readyok"); }
+
+void command_handler::handle_stop() { m_threads.stop(); }
 
 void command_handler::handle_go(const std::vector<std::string>& command,
                                 const board::position&          pos) {
-    if (command[1] == "depth") {
-        if (const auto parsed_depth = utils::parsing::to_number<u32>(command[2]))
-            m_searcher.set_limits(std::numeric_limits<u64>::max(), std::numeric_limits<u64>::max(),
+    // Every move after "searchmoves" restricts the root moves, until the first one that is not
+    // legal in the position. They are taken out of the command, so that the limits can be given
+    // either before or after them
+    std::vector<moves::move> search_moves;
+    std::vector<std::string> limits;
+
+    for (usize i = 0; i < command.size(); ++i) {
+        if (command[i] != "searchmoves") {
+            limits.push_back(command[i]);
+            continue;
+        }
+
+        for (; i + 1 < command.size(); ++i) {
+            const auto parsed_move = util::from_uci(pos, command[i + 1]);
+
+            if (parsed_move == moves::move::none())
+                break;
+
+            search_moves.push_back(parsed_move);
+        }
+    }
+
+    // Only "go infinite" (or "go" alone) withholds the best move until a stop is requested.
+    // Searching some moves without any other limit still ends on its own at the maximum depth
+    const bool infinite = command.size() < 2 || (limits.size() > 1 && limits[1] == "infinite");
+
+    if (infinite || limits.size() < 2) {
+        m_threads.set_limits(std::numeric_limits<u64>::max(), std::numeric_limits<u64>::max(),
+                             constants::max_depth);
+        m_threads.set_start_time(utils::time::get_time_ms());
+    }
+    else if (limits[1] == "depth") {
+        if (const auto parsed_depth = utils::parsing::to_number<u32>(limits[2]))
+            m_threads.set_limits(std::numeric_limits<u64>::max(), std::numeric_limits<u64>::max(),
                                   parsed_depth.value());
 
-        m_searcher.set_start_time(utils::time::get_time_ms());
+        m_threads.set_start_time(utils::time::get_time_ms());
     }
-    else if (command[1] == "perft") {
-        if (const auto parsed_perft_depth = utils::parsing::to_number<int>(command[2]))
-            split_perft(pos, parsed_perft_depth.value());
+    else if (limits[1] == "perft") {
+        if (const auto parsed_perft_depth = utils::parsing::to_number<int>(limits[2]))
+            split_perft(pos, parsed_perft_depth.value(), m_threads.size(),
+                        search::tt::global_tt.size_mb());
 
         return;
     }
-    else if (command[1] == "movetime") {
-        if (const auto parsed_move_time = utils::parsing::to_number<u64>(command[2]))
-            m_searcher.set_limits(std::numeric_limits<u64>::max(), parsed_move_time.value(),
+    else if (limits[1] == "movetime") {
+        if (const auto parsed_move_time = utils::parsing::to_number<u64>(limits[2]))
+            m_threads.set_limits(std::numeric_limits<u64>::max(), parsed_move_time.value(),
                                   constants::max_depth);
 
-        m_searcher.set_start_time(utils::time::get_time_ms());
+        m_threads.set_start_time(utils::time::get_time_ms());
     }
-    else if (command[1] == "nodes") {
-        if (const auto parsed_nodes = utils::parsing::to_number<u64>(command[2]))
-            m_searcher.set_limits(parsed_nodes.value(), std::numeric_limits<u64>::max(),
+    else if (limits[1] == "nodes") {
+        if (const auto parsed_nodes = utils::parsing::to_number<u64>(limits[2]))
+            m_threads.set_limits(parsed_nodes.value(), std::numeric_limits<u64>::max(),
                                   constants::max_depth);
 
-        m_searcher.set_start_time(utils::time::get_time_ms());
+        m_threads.set_start_time(utils::time::get_time_ms());
     }
-    else if (command[1] == "wtime" || command[1] == "btime") {
-        m_searcher.parse_time_control(command, pos.side_to_move());
+    else if (limits[1] == "wtime" || limits[1] == "btime") {
+        m_threads.parse_time_control(limits, pos.side_to_move());
     }
     else
-        std::cout << std::format("Unhandled go command: {}", command[1]) << std::endl;
+        utils::io::print_line(std::format("Unhandled go command: {}", limits[1]));
 
-    m_searcher.main_search(pos);
+    m_threads.set_search_moves(search_moves);
+    m_threads.start_search(pos, infinite);
 }
 
 void command_handler::handle_position(const std::vector<std::string>& command,
@@ -81,28 +119,99 @@ void command_handler::handle_position(const std::vector<std::string>& command,
             if (parsed_move == moves::move::none())
                 break;
 
-            pos.make_move<true>(parsed_move);
+            pos.make_move(parsed_move);
+
+            // Positions before an irreversible move can't be repeated anymore
+            if (pos.fifty_move_rule() == 0)
+                pos.clear_history();
         }
     }
 }
 
 void command_handler::handle_setoption(const std::vector<std::string>& command) {
     if (command[2] == "Hash") {
-        search::tt::global_tt.resize(std::stoul(command[4]));
+        if (const auto parsed_hash = utils::parsing::to_number<usize>(command[4])) {
+            const usize hash_mb =
+                std::clamp<usize>(parsed_hash.value(), search::tt::transposition_table::min_tt_size,
+                                  search::tt::transposition_table::max_tt_size);
+
+            if (!search::tt::global_tt.resize(hash_mb, m_threads.size()))
+                utils::io::print_line(std::format(
+                    "info string Failed to allocate {} MB for the hash table, using {} MB", hash_mb,
+                    search::tt::global_tt.size_mb()));
+        }
+    }
+    else if (command[2] == "Threads") {
+        if (const auto parsed_threads = utils::parsing::to_number<usize>(command[4]))
+            m_threads.resize(
+                std::clamp<usize>(parsed_threads.value(), 1, search::thread_pool::max_threads));
+    }
+    else if (command[2] == "MultiPV") {
+        if (const auto parsed_multi_pv = utils::parsing::to_number<usize>(command[4]))
+            m_threads.set_multi_pv(
+                std::clamp<usize>(parsed_multi_pv.value(), 1, search::thread_pool::max_multi_pv));
+    }
+    else if (command[2] == "Move" && command.size() > 5 && command[3] == "Overhead") {
+        if (const auto parsed_overhead = utils::parsing::to_number<u64>(command[5]))
+            m_threads.set_move_overhead(
+                std::min(parsed_overhead.value(), search::thread_pool::max_move_overhead));
+    }
+    else if (command[2] == "EvalFile") {
+        const std::string path = util::join_from(command, 4);
+
+        if (path.empty() || path == "<empty>") {
+            eval::nnue::unload_network();
+            utils::io::print_line("info string Using the hand-crafted evaluation");
+        }
+        else if (eval::nnue::load_network(path))
+            utils::io::print_line(std::format("info string Loaded network {}", path));
+        else
+            utils::io::print_line(std::format("info string Failed to load network {}", path));
     }
 }
 
 void command_handler::handle_uci() {
-    std::cout << std::format("id name {} {}", name, version) << std::endl;
-    std::cout << std::format("id author {}", author) << std::endl;
-    std::cout << "option name Hash type spin default 16 min 1 max 1024" << std::endl;
-    std::cout << "option name Threads type spin default 1 min 1 max 1" << std::endl;
-    std::cout << "uciok" << std::endl;
+    utils::io::print_line(std::format("id name {} {}", name, version));
+    utils::io::print_line(std::format("id author {}", author));
+    utils::io::print_line(std::format("option name Hash type spin default {} min {} max {}",
+                                      search::tt::transposition_table::default_tt_size,
+                                      search::tt::transposition_table::min_tt_size,
+                                      search::tt::transposition_table::max_tt_size));
+    utils::io::print_line(std::format("option name Threads type spin default 1 min 1 max {}",
+                                      search::thread_pool::max_threads));
+    utils::io::print_line(std::format("option name MultiPV type spin default 1 min 1 max {}",
+                                      search::thread_pool::max_multi_pv));
+    utils::io::print_line(std::format("option name Move Overhead type spin default {} min 0 max {}",
+                                      search::thread_pool::default_move_overhead,
+                                      search::thread_pool::max_move_overhead));
+    utils::io::print_line("option name EvalFile type string default <empty>");
+    utils::io::print_line("uciok");
 }
 
 void command_handler::handle_uci_new_game(board::position& pos) {
     pos.reset_to_start_pos();
-    search::tt::global_tt.clear();
+    search::tt::global_tt.clear(m_threads.size());
+}
+
+void command_handler::handle_save_hash(const std::vector<std::string>& command) {
+    const std::string path = util::join_from(command, 1);
+
+    if (search::tt::global_tt.save(path))
+        utils::io::print_line(std::format("info string Saved hash table to {}", path));
+    else
+        utils::io::print_line(
+            std::format("info string Failed to save hash table to {}", path));
+}
+
+void command_handler::handle_load_hash(const std::vector<std::string>& command) {
+    const std::string path = util::join_from(command, 1);
+
+    if (search::tt::global_tt.load(path, m_threads.size()))
+        utils::io::print_line(std::format("info string Loaded hash table from {} ({} MB)", path,
+                                          search::tt::global_tt.size_mb()));
+    else
+        utils::io::print_line(
+            std::format("info string Failed to load hash table from {}", path));
 }
 
 void command_handler::loop() {
@@ -115,6 +224,11 @@ void command_handler::loop() {
         if (command.empty())
             continue;
 
+        // Search runs in the background, so only "stop", "isready" and "quit" are handled while
+        // searching. Any other command waits for the current search to finish
+        if (command[0] != "stop" && command[0] != "isready" && command[0] != "quit")
+            m_threads.wait();
+
         if (command[0] == "d")
             handle_d(pos);
         else if (command[0] == "eval")
@@ -129,14 +243,24 @@ void command_handler::loop() {
             break;
         else if (command[0] == "setoption")
             handle_setoption(command);
+        else if (command[0] == "stop")
+            handle_stop();
         else if (command[0] == "uci")
             handle_uci();
         else if (command[0] == "ucinewgame")
             handle_uci_new_game(pos);
+        else if (command[0] == "savehash")
+            handle_save_hash(command);
+        else if (command[0] == "loadhash")
+            handle_load_hash(command);
         else {
-            std::cout << std::format("Unknown command: {}", command[0]) << std::endl;
+            utils::io::print_line(std::format("Unknown command: {}", command[0]));
         }
     }
+
+    // Both "quit" and the end of the input abort any ongoing search
+    handle_stop();
+    m_threads.wait();
 }
 
 namespace util {
@@ -153,6 +277,15 @@ moves::move from_uci(const board::position& pos, const std::string& move) {
     return moves::move::none();
 }
 
+std::string join_from(const std::vector<std::string>& command, const usize offset) {
+    std::string joined;
+
+    for (usize i = offset; i < command.size(); ++i)
+        joined += (i > offset ? " " : "") + command[i];
+
+    return joined;
+}
+
 } // namespace util
 
 } // namespace uci
\ No newline at end of file
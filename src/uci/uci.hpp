@@ -5,7 +5,7 @@
 #include <vector>
 
 #include "../board/position.hpp"
-#include "../search/search.hpp"
+#include "../search/threads.hpp"
 
 namespace uci {
 
@@ -18,22 +18,29 @@ class command_handler {
         static constexpr std::string_view name    = "Baryonyx";
         static constexpr std::string_view version = "0.1.17";
 
-        search::searcher m_searcher;
+        search::thread_pool m_threads;
 
         static void handle_d(const board::position& pos);
         static void handle_eval(const board::position& pos);
         static void handle_is_ready();
+        void        handle_stop();
         void        handle_go(const std::vector<std::string>& command, const board::position& pos);
         static void handle_position(const std::vector<std::string>& command, board::position& pos);
-        static void handle_setoption(const std::vector<std::string>& command);
+        void        handle_setoption(const std::vector<std::string>& command);
         static void handle_uci();
-        static void handle_uci_new_game(board::position& pos);
+        void        handle_uci_new_game(board::position& pos);
+        static void handle_save_hash(const std::vector<std::string>& command);
+        void        handle_load_hash(const std::vector<std::string>& command);
 };
 
 namespace util {
 
 moves::move from_uci(const board::position& pos, const std::string& move);
 
+/// @brief Joins the tokens of a command starting at the given one, e.g. paths that may contain
+/// spaces
+std::string join_from(const std::vector<std::string>& command, usize offset);
+
 }
 
 } // namespace uci
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+#endif
+
+#include "../types.hpp"
+
+namespace utils::cpu {
+
+/// @brief Instruction set extensions of the CPU running the engine, which may differ from the
+/// ones the binary was compiled for
+struct features {
+        bool bmi2;
+        bool avx2;
+        bool avx512bw;
+
+        /// @brief PEXT is implemented in microcode on AMD CPUs before Zen 3, where it is much
+        /// slower than magic multiplication
+        bool fast_pext;
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+/// @brief Checks if the OS saves the given register states (XCR0 bits) on context switches
+inline bool os_supports(const u32 xcr0_mask) {
+    u32 eax, edx;
+    asm volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (eax & xcr0_mask) == xcr0_mask;
+}
+#endif
+
+/// @brief Queries the CPU with cpuid
+/// @returns The supported extensions, or none of them on non-x86 CPUs
+inline features detect() {
+    features result{};
+
+#if defined(__x86_64__) || defined(__i386__)
+    u32 eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx))
+        return result;
+
+    const u32  max_leaf = eax;
+    const bool is_amd   = ebx == 0x68747541; // "AuthenticAMD"
+
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+
+    const u32 base_family = (eax >> 8) & 0xF;
+    const u32 family      = base_family == 0xF ? base_family + ((eax >> 20) & 0xFF) : base_family;
+
+    // YMM (bits 1-2) and ZMM (bits 5-7) states must be enabled by the OS to use AVX registers
+    const bool has_avx    = (ecx & bit_OSXSAVE) && (ecx & bit_AVX) && os_supports(0x06);
+    const bool has_avx512 = has_avx && os_supports(0xE6);
+
+    if (max_leaf >= 7) {
+        __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
+
+        result.bmi2     = ebx & bit_BMI2;
+        result.avx2     = has_avx && (ebx & bit_AVX2);
+        result.avx512bw = has_avx512 && (ebx & bit_AVX512F) && (ebx & bit_AVX512BW);
+    }
+
+    // Zen 3 is family 19h
+    result.fast_pext = result.bmi2 && !(is_amd && family < 0x19);
+#endif
+
+    return result;
+}
+
+/// @returns The features of the CPU, detected on the first call
+inline const features& get_features() {
+    static const features cpu_features = detect();
+    return cpu_features;
+}
+
+} // namespace utils::cpu
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <iostream>
+#include <mutex>
+#include <string_view>
+
+namespace utils::io {
+
+/// @brief Writes a whole line to the standard output and flushes it
+/// @param line Line to write, without the trailing newline
+/// @note The UCI thread and the search thread both write to the standard output, so lines are
+/// written under a lock. Otherwise, a "readyok" could end up in the middle of an info line
+inline void print_line(const std::string_view line) {
+    static std::mutex print_mutex;
+
+    const std::lock_guard lock(print_mutex);
+    std::cout << line << '\n' << std::flush;
+}
+
+} // namespace utils::io
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdlib>
+
+#if defined(_WIN32)
+    #include <malloc.h>
+#elif defined(__linux__)
+    #include <sys/mman.h>
+#endif
+
+#include "../types.hpp"
+
+namespace utils::memory {
+
+/// @brief Alignment of large allocations, matching the size of a huge page on x86-64
+inline constexpr usize huge_page_size = 2 * 1024 * 1024;
+
+/// @brief Allocates a large block of memory aligned to a huge page boundary and, where supported,
+/// asks the OS to back it with transparent huge pages to reduce TLB misses
+/// @param size Size of the block, in bytes
+/// @returns Pointer to the uninitialized block, or nullptr if the allocation failed
+/// @note Memory must be released with free_huge_pages
+inline void* alloc_huge_pages(const usize size) {
+    // aligned_alloc requires the size to be a multiple of the alignment
+    const usize aligned_size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+
+#if defined(_WIN32)
+    return _aligned_malloc(aligned_size, huge_page_size);
+#else
+    void* ptr = std::aligned_alloc(huge_page_size, aligned_size);
+
+    #if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (ptr != nullptr)
+        madvise(ptr, aligned_size, MADV_HUGEPAGE);
+    #endif
+
+    return ptr;
+#endif
+}
+
+/// @brief Releases a block of memory allocated with alloc_huge_pages
+/// @param ptr Pointer to the block (may be nullptr)
+inline void free_huge_pages(void* ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+} // namespace utils::memory
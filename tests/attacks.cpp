@@ -1,4 +1,5 @@
 #include "../src/board/bitboard/attacks.hpp"
+#include "../src/utils/random.hpp"
 #include "doctest/doctest.hpp"
 
 using namespace board::bitboards;
@@ -43,7 +44,6 @@ TEST_SUITE("Attacks Test") {
     }
 
     TEST_CASE("sliding attacks") {
-        attacks::init();
         SUBCASE("bishop attacks") {
             CHECK_EQ(
                 attacks::gen_sliding<piece_type::bishop>(square::e4, bitboard(0x440000004400ULL)),
@@ -70,4 +70,40 @@ TEST_SUITE("Attacks Test") {
                      bitboard(0x10101010106E10ULL));
         }
     }
+
+    TEST_CASE("packed slider attacks") {
+
+        // Each square only takes as many entries as blocker configurations of its mask
+        CHECK_EQ(attacks::slider_table_size, 5248 + 102400);
+
+        utils::random::sfc64_rng prng;
+
+        for (u8 sq = 0; sq < constants::num_squares; ++sq) {
+            const auto from = static_cast<square>(sq);
+
+            for (int i = 0; i < 64; ++i) {
+                const bitboard blockers(prng.next_u64() & prng.next_u64());
+
+                CHECK_EQ(attacks::get_bishop_attacks(from, blockers),
+                         attacks::gen_sliding<piece_type::bishop>(from, blockers));
+                CHECK_EQ(attacks::get_rook_attacks(from, blockers),
+                         attacks::gen_sliding<piece_type::rook>(from, blockers));
+            }
+        }
+    }
+
+    TEST_CASE("between and line") {
+        SUBCASE("aligned squares") {
+            CHECK_EQ(attacks::get_between(square::a1, square::a8), bitboard(0x1010101010100ULL));
+            CHECK_EQ(attacks::get_between(square::c1, square::f4), bitboard(0x100800ULL));
+            CHECK_EQ(attacks::get_between(square::e4, square::f5), util::empty_bb);
+            CHECK_EQ(attacks::get_line(square::b2, square::c3), bitboard(0x8040201008040201ULL));
+            CHECK_EQ(attacks::get_line(square::d1, square::g1), util::rank_1_bb);
+        }
+
+        SUBCASE("unaligned squares") {
+            CHECK_EQ(attacks::get_between(square::a1, square::b3), util::empty_bb);
+            CHECK_EQ(attacks::get_line(square::a1, square::b3), util::empty_bb);
+        }
+    }
 }
\ No newline at end of file
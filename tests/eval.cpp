@@ -0,0 +1,24 @@
+#include "../src/eval/eval.hpp"
+#include "doctest/doctest.hpp"
+
+using namespace board;
+
+TEST_SUITE("Evaluation Tests") {
+    TEST_CASE("pawn structure") {
+        // Passed, isolated, doubled and backward pawns for both sides, and the same position with
+        // the colors swapped
+        const position pos("4k3/1p3pp1/1p6/p2P4/6P1/2P4P/P7/4K3 w - - 0 1");
+        const position mirrored("4k3/p7/2p4p/6p1/P2p4/1P6/1P3PP1/4K3 b - - 0 1");
+
+        eval::pawns::pawn_table table;
+
+        CHECK_EQ(eval::pawns::evaluate(pos, nullptr),
+                 eval::pawns::evaluate(mirrored, nullptr) * -1);
+        CHECK_EQ(eval::evaluate(pos), eval::evaluate(mirrored));
+
+        // Cached scores are the same as the computed ones
+        CHECK_EQ(eval::pawns::evaluate(pos, &table), eval::pawns::evaluate(pos, nullptr));
+        CHECK_EQ(eval::pawns::evaluate(pos, &table), eval::pawns::evaluate(pos, nullptr));
+        CHECK_EQ(eval::pawns::evaluate(mirrored, &table), eval::pawns::evaluate(mirrored, nullptr));
+    }
+}
@@ -0,0 +1,174 @@
+#include "../src/moves/movegen.hpp"
+#include "../src/moves/movepicker.hpp"
+#include "../src/utils/split.hpp"
+#include "doctest/doctest.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace board;
+using namespace moves;
+
+TEST_SUITE("Move Picker Tests") {
+    // clang-format off
+    const std::array perft_suite = {
+        #include "./resources/perft_suite.txt"
+    };
+    // clang-format on
+
+    std::vector<position> suite_positions() {
+        std::vector<position> positions;
+
+        for (const auto& test : perft_suite)
+            positions.emplace_back(utils::split::split_string(test, ';')[0]);
+
+        return positions;
+    }
+
+    std::vector<u16> sorted_moves(const std::vector<move>& moves) {
+        std::vector<u16> result;
+
+        for (const auto& m : moves)
+            result.push_back(static_cast<u16>(std::to_underlying(m.from())
+                                              | std::to_underlying(m.to()) << 6
+                                              | std::to_underlying(m.flag()) << 12));
+
+        std::ranges::sort(result);
+        return result;
+    }
+
+    TEST_CASE("legality") {
+        const auto positions = suite_positions();
+
+        for (const auto& pos : positions) {
+            move_list own_moves;
+            generate_all_moves(pos, own_moves);
+
+            // Generated moves never leave the king in check
+            for (const auto& [move_score, m] : own_moves) {
+                auto child = pos;
+                child.make_move(m);
+
+                CHECK(child.was_legal());
+            }
+
+            // Moves from other positions are only valid (as tt moves or killers are) if they would
+            // have been generated too
+            for (const auto& other : positions) {
+                move_list other_moves;
+                generate_all_moves(other, other_moves);
+
+                for (const auto& [move_score, m] : other_moves) {
+                    const bool generated = std::ranges::any_of(
+                        own_moves, [&](const scored_move& own) { return own.move_value == m; });
+
+                    CHECK_EQ(pos.is_pseudo_legal(m) && pos.is_legal(m), generated);
+                }
+            }
+        }
+
+        const position start_pos(util::start_pos_fen);
+        const move     e2e4_quiet(square::e2, square::e4, move::move_flag::quiet);
+        const move     e2e4(square::e2, square::e4, move::move_flag::double_push);
+        const move     e7e5(square::e7, square::e5, move::move_flag::double_push);
+
+        CHECK_FALSE(start_pos.is_pseudo_legal(move::null()));
+        CHECK_FALSE(start_pos.is_pseudo_legal(move::none()));
+        CHECK_FALSE(start_pos.is_pseudo_legal(e2e4_quiet));
+        CHECK_FALSE(start_pos.is_pseudo_legal(e7e5));
+        CHECK(start_pos.is_pseudo_legal(e2e4));
+    }
+
+    TEST_CASE("picks every move once") {
+        search::search_data search_data;
+
+        for (const auto& pos : suite_positions()) {
+            move_list move_list;
+            generate_all_moves(pos, move_list);
+
+            std::vector<move> generated;
+            std::vector<move> quiets;
+
+            for (const auto& [move_score, m] : move_list) {
+                generated.push_back(m);
+
+                if (m.is_quiet())
+                    quiets.push_back(m);
+            }
+
+            // Use some of the generated moves as tt move and killers, so they are tried first
+            if (!quiets.empty()) {
+                search_data.clear_killers();
+                search_data.update_killers(quiets.front(), 0);
+                search_data.update_killers(quiets.back(), 0);
+            }
+
+            const move tt_move = generated.empty() ? move::null() : generated.back();
+
+            move_picker       picker(pos, tt_move, search_data, 0, false);
+            std::vector<move> picked;
+
+            for (move m = picker.next(); m != move::null(); m = picker.next())
+                picked.push_back(m);
+
+            CHECK_EQ(picker.current_stage(), move_picker::stage::done);
+            CHECK_EQ(sorted_moves(picked), sorted_moves(generated));
+
+            if (tt_move != move::null())
+                CHECK_EQ(picked.front(), tt_move);
+        }
+    }
+
+    TEST_CASE("captures only") {
+        const position pos("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        const search::search_data search_data;
+
+        move_list captures;
+        generate_all_captures(pos, captures);
+
+        move_picker picker(pos, move(square::e1, square::g1, move::move_flag::castle), search_data,
+                           0, true);
+        usize       picked{};
+
+        for (move m = picker.next(); m != move::null(); m = picker.next()) {
+            CHECK(m.is_capture());
+            ++picked;
+        }
+
+        CHECK_EQ(picked, captures.size());
+    }
+
+    TEST_CASE("evasions") {
+        const search::search_data search_data;
+
+        for (const auto& pos : suite_positions()) {
+            if (pos.checkers().empty())
+                continue;
+
+            move_list all_moves;
+            move_list evasions;
+            generate_all_moves(pos, all_moves);
+            generate_all_evasions(pos, evasions);
+
+            std::vector<move> generated;
+            std::vector<move> generated_evasions;
+
+            for (const auto& [move_score, m] : all_moves)
+                generated.push_back(m);
+
+            for (const auto& [move_score, m] : evasions)
+                generated_evasions.push_back(m);
+
+            CHECK_EQ(sorted_moves(generated_evasions), sorted_moves(generated));
+
+            // Quiescence search picks every evasion when in check, not only the captures
+            move_picker       picker(pos, move::null(), search_data, 0, true);
+            std::vector<move> picked;
+
+            for (move m = picker.next(); m != move::null(); m = picker.next())
+                picked.push_back(m);
+
+            CHECK_EQ(sorted_moves(picked), sorted_moves(generated));
+        }
+    }
+}
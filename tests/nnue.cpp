@@ -0,0 +1,86 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "../src/eval/nnue.hpp"
+#include "../src/moves/movegen.hpp"
+#include "doctest/doctest.hpp"
+
+using namespace board;
+using namespace eval::nnue;
+
+TEST_SUITE("NNUE Tests") {
+    /// @brief Writes a network with random parameters, small enough to never overflow the
+    /// accumulators
+    std::filesystem::path write_random_network(const usize parameter_count) {
+        const auto path = std::filesystem::temp_directory_path() / "baryonyx_test.nnue";
+
+        std::mt19937                       rng(42);
+        std::uniform_int_distribution<i16> distribution(-64, 64);
+        std::ofstream                      file(path, std::ios::binary);
+
+        for (usize i = 0; i < parameter_count; ++i) {
+            const i16 value = distribution(rng);
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        return path;
+    }
+
+    /// @brief Checks that the incrementally updated accumulator matches a refreshed one
+    void check_accumulator(const position& pos) {
+        auto              refreshed_pos = pos;
+        accumulator_stack refreshed;
+
+        refreshed_pos.set_accumulators(&refreshed);
+
+        CHECK(pos.accumulators()->current().values == refreshed.current().values);
+    }
+
+    void check_moves(position& pos, const int depth) {
+        moves::move_list move_list;
+        moves::generate_all_moves(pos, move_list);
+
+        for (const auto& [move_score, current_move] : move_list) {
+            pos.make_move(current_move);
+            check_accumulator(pos);
+
+            if (depth > 1)
+                check_moves(pos, depth - 1);
+
+            pos.unmake_move(current_move);
+            check_accumulator(pos);
+        }
+    }
+
+    constexpr usize parameter_count = input_size * hidden_size + hidden_size * 3 + 1;
+
+    TEST_CASE("network loading") {
+        const auto path = write_random_network(parameter_count - 1);
+
+        CHECK_FALSE(load_network(path.string()));
+        CHECK_FALSE(network_loaded());
+
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("incremental updates") {
+        const auto path = write_random_network(parameter_count);
+
+        REQUIRE(load_network(path.string()));
+
+        // Castling, en passant and promotions (with and without capture) are reachable
+        for (const auto& fen :
+             {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+              "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1"}) {
+            position          pos(fen);
+            accumulator_stack accumulators;
+
+            pos.set_accumulators(&accumulators);
+            check_moves(pos, 2);
+        }
+
+        unload_network();
+        std::filesystem::remove(path);
+    }
+}
@@ -2,6 +2,9 @@
 #include "../src/utils/split.hpp"
 #include "doctest/doctest.hpp"
 
+#include <iostream>
+#include <sstream>
+
 TEST_SUITE("Perft tests") {
     // clang-format off
     const std::array perft_suite = {
@@ -23,4 +26,32 @@ TEST_SUITE("Perft tests") {
             }
         }
     }
+
+    TEST_CASE("split perft suite with threads and hash") {
+        // The table is kept small so that entries are overwritten while the threads share it
+        constexpr usize thread_count = 4;
+        constexpr usize hash_mb      = 1;
+        constexpr u64   max_nodes    = 5'000'000;
+
+        std::ostringstream output;
+        auto*              previous_buffer = std::cout.rdbuf(output.rdbuf());
+
+        for (const auto& test : perft_suite) {
+            const auto            perft_test = utils::split::split_string(test, ';');
+            const board::position test_pos(perft_test[0]);
+
+            for (usize i = 1; i < perft_test.size(); ++i) {
+                const auto test_data      = utils::split::split_string(perft_test[i], ' ');
+                const int  test_depth     = std::stoi(test_data[0].substr(1));
+                const u64  expected_nodes = std::stoi(test_data[1]);
+
+                if (expected_nodes > max_nodes)
+                    break;
+
+                CHECK_EQ(split_perft(test_pos, test_depth, thread_count, hash_mb), expected_nodes);
+            }
+        }
+
+        std::cout.rdbuf(previous_buffer);
+    }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "../src/board/position.hpp"
 #include "doctest/doctest.hpp"
 
+#include <array>
 #include <stdexcept>
 
 using namespace board;
@@ -80,7 +81,7 @@ TEST_SUITE("Position Tests") {
 
         SUBCASE("after double push") {
             position pos(util::start_pos_fen);
-            pos.make_move<false>(move(square::e2, square::e4, move::move_flag::double_push));
+            pos.make_move(move(square::e2, square::e4, move::move_flag::double_push));
 
             CHECK_EQ(pos.key(),
                      position("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1").key());
@@ -88,7 +89,7 @@ TEST_SUITE("Position Tests") {
 
         SUBCASE("after castling") {
             position pos("rnbqk2r/pppp1ppp/5n2/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
-            pos.make_move<false>(move(square::e1, square::g1, move::move_flag::castle));
+            pos.make_move(move(square::e1, square::g1, move::move_flag::castle));
 
             CHECK_EQ(pos.key(),
                      position("rnbqk2r/pppp1ppp/5n2/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQ1RK1 b kq - 5 4")
@@ -97,24 +98,108 @@ TEST_SUITE("Position Tests") {
 
         SUBCASE("after en passant") {
             position pos("rnbqkbnr/ppp2ppp/4p3/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3");
-            pos.make_move<false>(move(square::e5, square::d6, move::move_flag::en_passant));
+            pos.make_move(move(square::e5, square::d6, move::move_flag::en_passant));
 
             CHECK_EQ(pos.key(),
                      position("rnbqkbnr/ppp2ppp/3Pp3/8/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 3").key());
         }
+
+        SUBCASE("pawn key") {
+            position pos(util::start_pos_fen);
+            pos.reset_to_start_pos();
+
+            CHECK_EQ(pos.pawn_key(), position(util::start_pos_fen).pawn_key());
+
+            // Only pawn moves change the pawn key
+            const auto start_pawn_key = pos.pawn_key();
+            pos.make_move(move(square::g1, square::f3, move::move_flag::quiet));
+
+            CHECK_EQ(pos.pawn_key(), start_pawn_key);
+
+            pos.make_move(move(square::e7, square::e5, move::move_flag::double_push));
+
+            CHECK_NE(pos.pawn_key(), start_pawn_key);
+            CHECK_EQ(position("8/4k3/8/8/8/8/8/4K3 w - - 0 1").pawn_key(), 0ULL);
+        }
+    }
+
+    TEST_CASE("unmake move") {
+        auto check_unmake = [](const std::string& fen, const move m) {
+            position   pos(fen);
+            const auto key_after = pos.key_after(m);
+            pos.make_move(m);
+
+            const position after_move(pos.to_fen());
+            CHECK_EQ(pos.key(), key_after);
+            CHECK_EQ(pos.psqt_score(), after_move.psqt_score());
+            CHECK_EQ(pos.game_phase(), after_move.game_phase());
+            CHECK_EQ(pos.pawn_key(), after_move.pawn_key());
+
+            pos.unmake_move(m);
+
+            CHECK_EQ(pos.to_fen(), fen);
+            CHECK_EQ(pos.key(), position(fen).key());
+            CHECK_EQ(pos.checkers(), position(fen).checkers());
+            CHECK_EQ(pos.psqt_score(), position(fen).psqt_score());
+            CHECK_EQ(pos.game_phase(), position(fen).game_phase());
+            CHECK_EQ(pos.pawn_key(), position(fen).pawn_key());
+        };
+
+        SUBCASE("quiet and double push") {
+            check_unmake(util::start_pos_fen, move(square::g1, square::f3, move::move_flag::quiet));
+            check_unmake(util::start_pos_fen,
+                         move(square::e2, square::e4, move::move_flag::double_push));
+        }
+
+        SUBCASE("capture") {
+            check_unmake("r1bqkbnr/pppp1ppp/2n5/4p3/3PP3/5N2/PPP2PPP/RNBQKB1R b KQkq d3 0 3",
+                         move(square::e5, square::d4, move::move_flag::capture));
+        }
+
+        SUBCASE("en passant") {
+            check_unmake("rnbqkbnr/ppp2ppp/4p3/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3",
+                         move(square::e5, square::d6, move::move_flag::en_passant));
+        }
+
+        SUBCASE("castling") {
+            check_unmake("rnbqk2r/pppp1ppp/5n2/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+                         move(square::e1, square::g1, move::move_flag::castle));
+            check_unmake("r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1",
+                         move(square::e8, square::c8, move::move_flag::castle));
+        }
+
+        SUBCASE("promotion") {
+            check_unmake("r3k3/1P6/8/8/8/8/8/4K3 w q - 0 1",
+                         move(square::b7, square::a8, move::move_flag::queen_capture_promo));
+            check_unmake("4k3/8/8/8/8/8/p7/4K3 b - - 0 1",
+                         move(square::a2, square::a1, move::move_flag::knight_promo));
+        }
+
+        SUBCASE("null move") {
+            constexpr auto fen = "rnbqkbnr/ppp2ppp/4p3/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3";
+            position       pos(fen);
+
+            pos.make_null_move();
+            CHECK_EQ(pos.side_to_move(), color::black);
+            CHECK_EQ(pos.ep_square(), square::none);
+
+            pos.unmake_null_move();
+            CHECK_EQ(pos.to_fen(), fen);
+            CHECK_EQ(pos.key(), position(fen).key());
+        }
     }
 
     TEST_CASE("repetition detection") {
         SUBCASE("position 1 ") {
             position pos("4r1k1/p2r1p2/1p3BpQ/2p5/4p1PP/2P3qB/PP6/5R1K b - - 5 30");
 
-            pos.make_move<true>(move(square::g3, square::h3, move::move_flag::capture));
-            pos.make_move<true>(move(square::h1, square::g1, move::move_flag::quiet));
-            pos.make_move<true>(move(square::h3, square::g3, move::move_flag::quiet));
-            pos.make_move<true>(move(square::g1, square::h1, move::move_flag::quiet));
-            pos.make_move<true>(move(square::g3, square::h3, move::move_flag::quiet));
-            pos.make_move<true>(move(square::h1, square::g1, move::move_flag::quiet));
-            pos.make_move<true>(move(square::h3, square::g3, move::move_flag::quiet));
+            pos.make_move(move(square::g3, square::h3, move::move_flag::capture));
+            pos.make_move(move(square::h1, square::g1, move::move_flag::quiet));
+            pos.make_move(move(square::h3, square::g3, move::move_flag::quiet));
+            pos.make_move(move(square::g1, square::h1, move::move_flag::quiet));
+            pos.make_move(move(square::g3, square::h3, move::move_flag::quiet));
+            pos.make_move(move(square::h1, square::g1, move::move_flag::quiet));
+            pos.make_move(move(square::h3, square::g3, move::move_flag::quiet));
 
             CHECK_EQ(pos.has_repeated(), true);
         }
@@ -122,15 +207,38 @@ TEST_SUITE("Position Tests") {
         SUBCASE("position 2") {
             position pos("r3kr2/p1R5/1p5Q/7p/3P3q/P1P5/1P4P1/R6K w - - 0 30");
 
-            pos.make_move<true>(move(square::h1, square::g1, move::move_flag::quiet));
-            pos.make_move<true>(move(square::h4, square::f2, move::move_flag::quiet));
-            pos.make_move<true>(move(square::g1, square::h1, move::move_flag::quiet));
-            pos.make_move<true>(move(square::f2, square::h4, move::move_flag::quiet));
-            pos.make_move<true>(move(square::h1, square::g1, move::move_flag::quiet));
-            pos.make_move<true>(move(square::h4, square::f2, move::move_flag::quiet));
-            pos.make_move<true>(move(square::g1, square::h1, move::move_flag::quiet));
+            pos.make_move(move(square::h1, square::g1, move::move_flag::quiet));
+            pos.make_move(move(square::h4, square::f2, move::move_flag::quiet));
+            pos.make_move(move(square::g1, square::h1, move::move_flag::quiet));
+            pos.make_move(move(square::f2, square::h4, move::move_flag::quiet));
+            pos.make_move(move(square::h1, square::g1, move::move_flag::quiet));
+            pos.make_move(move(square::h4, square::f2, move::move_flag::quiet));
+            pos.make_move(move(square::g1, square::h1, move::move_flag::quiet));
 
             CHECK_EQ(pos.has_repeated(), true);
         }
+
+        SUBCASE("history longer than the game ply limit") {
+            position pos(util::start_pos_fen);
+
+            const std::array shuffle = {move(square::g1, square::f3, move::move_flag::quiet),
+                                        move(square::g8, square::f6, move::move_flag::quiet),
+                                        move(square::f3, square::g1, move::move_flag::quiet),
+                                        move(square::f6, square::g8, move::move_flag::quiet)};
+
+            // Shuffling the knights never resets the history, so the oldest states are dropped
+            for (int i = 0; i < 3 * constants::max_game_ply; ++i)
+                pos.make_move(shuffle[i % shuffle.size()]);
+
+            CHECK_EQ(pos.has_repeated(), true);
+
+            pos.unmake_move(shuffle.back());
+            pos.unmake_move(shuffle[2]);
+
+            constexpr auto fen = "rnbqkb1r/pppppppp/5n2/8/8/5N2/PPPPPPPP/RNBQKB1R w KQkq - 2 3";
+
+            CHECK_EQ(pos.piece_on(square::f3), piece::w_knight);
+            CHECK_EQ(pos.key(), position(fen).key());
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "../src/search/threads.hpp"
+#include "doctest/doctest.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#include "../src/moves/movegen.hpp"
+#include "../src/search/tt.hpp"
+#include "../src/utils/time.hpp"
+
+using namespace search;
+
+TEST_SUITE("Search Tests") {
+    /// @brief Searches the position to the given depth, capturing the reported output
+    std::string search_output(const std::string&              fen,
+                              const u32                       depth,
+                              const usize                     multi_pv,
+                              const std::vector<moves::move>& search_moves = {}) {
+        std::ostringstream output;
+        auto*              previous_buffer = std::cout.rdbuf(output.rdbuf());
+
+        thread_pool pool;
+        pool.set_multi_pv(multi_pv);
+        pool.set_search_moves(search_moves);
+        pool.set_limits(std::numeric_limits<u64>::max(), std::numeric_limits<u64>::max(), depth);
+        pool.set_start_time(utils::time::get_time_ms());
+        pool.start_search(board::position(fen), false);
+        pool.wait();
+
+        std::cout.rdbuf(previous_buffer);
+
+        return output.str();
+    }
+
+    /// @brief Parses the node count of the last info line of a search output
+    u64 reported_nodes(const std::string& output) {
+        std::istringstream tokens(output.substr(output.rfind("info depth")));
+        std::string        token;
+        u64                nodes{};
+
+        while (tokens >> token && token != "nodes") {}
+
+        tokens >> nodes;
+
+        return nodes;
+    }
+
+    TEST_CASE("multipv lines are sorted by score") {
+        const std::string output = search_output(board::util::start_pos_fen, 10, 4);
+
+        std::istringstream lines(output);
+        std::string        line;
+        int                reported_lines = 0;
+        int                previous_score = std::numeric_limits<int>::max();
+
+        while (std::getline(lines, line)) {
+            // Bounds reported while a line fails high or low are not part of the final order
+            if (!line.starts_with("info depth") || line.find("bound") != std::string::npos)
+                continue;
+
+            std::istringstream tokens(line);
+            std::string        token;
+            usize              pv_index{};
+            int                current_score{};
+
+            while (tokens >> token) {
+                if (token == "multipv")
+                    tokens >> pv_index;
+                else if (token == "cp")
+                    tokens >> current_score;
+            }
+
+            if (pv_index == 1)
+                previous_score = std::numeric_limits<int>::max();
+
+            CHECK(current_score <= previous_score);
+
+            previous_score = current_score;
+            ++reported_lines;
+        }
+
+        CHECK_EQ(reported_lines, 10 * 4);
+        CHECK(output.find("bestmove") != std::string::npos);
+    }
+
+    TEST_CASE("searchmoves results are not stored as the root score") {
+        const board::position pos(board::util::start_pos_fen);
+
+        tt::global_tt.clear();
+
+        // Only a bad move is allowed, so its score is much lower than the one of the position
+        const std::string output =
+            search_output(board::util::start_pos_fen, 8, 1,
+                          {moves::move(square::g1, square::h3, moves::move::move_flag::quiet)});
+
+        CHECK(output.find("bestmove g1h3") != std::string::npos);
+
+        tt::tt_entry entry;
+
+        if (tt::global_tt.probe(pos.key(), entry))
+            CHECK(entry.flag() == tt::tt_entry::tt_flag::lower_bound);
+    }
+
+    TEST_CASE("lazy smp search with helper threads") {
+        // Deep enough for the helpers to get their share of the search even on a single core
+        constexpr u32         depth = 12;
+        const board::position pos(board::util::start_pos_fen);
+
+        tt::global_tt.clear();
+        const u64 single_thread_nodes =
+            reported_nodes(search_output(board::util::start_pos_fen, depth, 1));
+
+        tt::global_tt.clear();
+
+        std::ostringstream output;
+        auto*              previous_buffer = std::cout.rdbuf(output.rdbuf());
+
+        thread_pool pool;
+        pool.resize(4);
+        pool.set_limits(std::numeric_limits<u64>::max(), std::numeric_limits<u64>::max(), depth);
+        pool.set_start_time(utils::time::get_time_ms());
+        pool.start_search(pos, false);
+        pool.wait();
+
+        std::cout.rdbuf(previous_buffer);
+
+        // The helpers are stopped and joined along with the main thread, so no one keeps counting
+        const u64 total_nodes = pool.searched_nodes();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        CHECK_EQ(pool.searched_nodes(), total_nodes);
+
+        // The reported nodes include the ones of the helpers, which search on their own besides
+        // the main thread
+        CHECK(reported_nodes(output.str()) <= total_nodes);
+        CHECK(reported_nodes(output.str()) > single_thread_nodes);
+
+        const auto best_move_pos = output.str().rfind("bestmove ");
+        REQUIRE(best_move_pos != std::string::npos);
+
+        std::istringstream best_move_line(output.str().substr(best_move_pos));
+        std::string        best_move;
+        best_move_line >> best_move >> best_move;
+
+        moves::move_list move_list;
+        moves::generate_all_moves(pos, move_list);
+
+        bool legal = false;
+
+        for (const auto& [move_score, current_move] : move_list)
+            legal = legal || current_move.to_string() == best_move;
+
+        CHECK(legal);
+    }
+}
\ No newline at end of file
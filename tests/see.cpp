@@ -0,0 +1,56 @@
+#include "../src/moves/see.hpp"
+#include "doctest/doctest.hpp"
+
+using namespace board;
+using namespace moves;
+
+TEST_SUITE("SEE Tests") {
+    score value(const piece_type pt) { return see_values[std::to_underlying(pt)]; }
+
+    /// @brief Checks that the exchange of the move gives exactly the expected material balance
+    void check_see(const std::string& fen, const move m, const score expected) {
+        const position pos(fen);
+
+        CHECK(see(pos, m, expected));
+        CHECK_FALSE(see(pos, m, expected + 1));
+    }
+
+    TEST_CASE("undefended capture") {
+        check_see("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1",
+                  move(square::e1, square::e5, move::move_flag::capture), value(piece_type::pawn));
+    }
+
+    TEST_CASE("defended capture") {
+        check_see("4k3/8/2p5/3p4/4P3/8/8/4K3 w - - 0 1",
+                  move(square::e4, square::d5, move::move_flag::capture), 0);
+        check_see("4k3/8/2p5/3p4/8/8/8/3QK3 w - - 0 1",
+                  move(square::d1, square::d5, move::move_flag::capture),
+                  value(piece_type::pawn) - value(piece_type::queen));
+    }
+
+    TEST_CASE("en passant") {
+        check_see("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1",
+                  move(square::e5, square::d6, move::move_flag::en_passant),
+                  value(piece_type::pawn));
+    }
+
+    TEST_CASE("quiet move to an attacked square") {
+        check_see("4k3/8/8/3p4/8/8/5N2/4K3 w - - 0 1",
+                  move(square::f2, square::e4, move::move_flag::quiet), -value(piece_type::knight));
+    }
+
+    TEST_CASE("x-ray attackers") {
+        check_see("4k3/4r3/8/8/4p3/8/4R3/4R1K1 w - - 0 1",
+                  move(square::e2, square::e4, move::move_flag::capture), value(piece_type::pawn));
+        check_see("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1",
+                  move(square::d3, square::e5, move::move_flag::capture),
+                  value(piece_type::pawn) - value(piece_type::knight));
+    }
+
+    TEST_CASE("king captures") {
+        check_see("4k3/8/8/8/8/3r4/3R4/3K4 b - - 0 1",
+                  move(square::d3, square::d2, move::move_flag::capture), 0);
+        check_see("3rk3/8/8/8/8/3r4/3R4/3K4 b - - 0 1",
+                  move(square::d3, square::d2, move::move_flag::capture), value(piece_type::rook));
+    }
+}
@@ -0,0 +1,56 @@
+#include "../src/timeman.hpp"
+#include "doctest/doctest.hpp"
+
+TEST_SUITE("Time Management Tests") {
+    TEST_CASE("limits") {
+        const time_manager timer(0, 10000, 100, 0, 10);
+
+        CHECK(timer.soft_limit() > 0);
+        CHECK(timer.soft_limit() <= timer.hard_limit());
+        CHECK(timer.hard_limit() < 10000);
+
+        // The move overhead is never spent, even if it takes most of the clock
+        const time_manager short_timer(0, 50, 0, 1, 40);
+
+        CHECK(short_timer.hard_limit() <= 10);
+    }
+
+    TEST_CASE("soft limit scaling") {
+        time_manager timer(0, 60000, 0, 40, 10);
+        const u64    base_limit = timer.soft_limit();
+
+        timer.scale_soft_limit(0, 0, 0.75);
+        const u64 unstable_limit = timer.soft_limit();
+
+        timer.scale_soft_limit(10, 0, 0.75);
+        const u64 stable_limit = timer.soft_limit();
+
+        timer.scale_soft_limit(10, 50, 0.75);
+        const u64 dropping_limit = timer.soft_limit();
+
+        CHECK(unstable_limit > base_limit);
+        CHECK(stable_limit < base_limit);
+        CHECK(dropping_limit > stable_limit);
+        CHECK(unstable_limit <= timer.hard_limit());
+    }
+
+    TEST_CASE("node fraction scaling") {
+        time_manager timer(0, 60000, 0, 40, 10);
+
+        timer.scale_soft_limit(2, 0, 0.95);
+        const u64 obvious_limit = timer.soft_limit();
+
+        timer.scale_soft_limit(2, 0, 0.40);
+        const u64 contested_limit = timer.soft_limit();
+
+        CHECK(obvious_limit < contested_limit);
+    }
+
+    TEST_CASE("no clock") {
+        time_manager timer;
+
+        timer.scale_soft_limit(0, 100, 0.0);
+
+        CHECK_FALSE(timer.soft_limit_reached());
+    }
+}
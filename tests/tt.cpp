@@ -0,0 +1,122 @@
+#include "../src/search/tt.hpp"
+#include "doctest/doctest.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace search::tt;
+
+TEST_SUITE("Transposition Table Tests") {
+    constexpr zobrist_key key = 0x9D39247E33776D41ULL;
+
+    const moves::move tt_move(square::e2, square::e4, moves::move::move_flag::double_push);
+    const tt_entry    entry(key, tt_move, 42, 7, tt_entry::tt_flag::exact);
+
+    TEST_CASE("store and probe") {
+        transposition_table table(1);
+        tt_entry            probed;
+
+        CHECK_FALSE(table.probe(key, probed));
+
+        table.store(key, entry);
+
+        REQUIRE(table.probe(key, probed));
+        CHECK_EQ(probed.move(), entry.move());
+        CHECK_EQ(probed.value(), entry.value());
+        CHECK_EQ(probed.depth(), entry.depth());
+    }
+
+    // Keys sharing their high bits are mapped to the same bucket
+    constexpr zobrist_key bucket_key = 0x9D39247E00000000ULL;
+
+    TEST_CASE("keys are fully checked") {
+        transposition_table table(1);
+        tt_entry            probed;
+
+        table.store(bucket_key | 1,
+                    tt_entry(bucket_key | 1, tt_move, 42, 7, tt_entry::tt_flag::exact));
+
+        // Same bucket and same low 16 bits, but a different position
+        CHECK_FALSE(table.probe(bucket_key | (1 << 16) | 1, probed));
+        CHECK(table.probe(bucket_key | 1, probed));
+    }
+
+    TEST_CASE("shallow entries don't evict deep ones from the current search") {
+        transposition_table table(1);
+        tt_entry            probed;
+
+        table.store(bucket_key,
+                    tt_entry(bucket_key, tt_move, 42, 20, tt_entry::tt_flag::lower_bound));
+
+        for (zobrist_key i = 1; i <= 2 * tt_bucket::num_entries; ++i) {
+            const zobrist_key shallow_key = bucket_key | i;
+            table.store(shallow_key,
+                        tt_entry(shallow_key, tt_move, 0, 0, tt_entry::tt_flag::upper_bound));
+        }
+
+        // Nor does a shallow entry of the same position
+        table.store(bucket_key,
+                    tt_entry(bucket_key, tt_move, 0, 0, tt_entry::tt_flag::upper_bound));
+
+        REQUIRE(table.probe(bucket_key, probed));
+        CHECK_EQ(probed.depth(), 20);
+        CHECK_EQ(probed.value(), 42);
+    }
+
+    TEST_CASE("entries from previous searches are replaced first") {
+        transposition_table table(1);
+        tt_entry            probed;
+
+        table.store(bucket_key, tt_entry(bucket_key, tt_move, 42, 7, tt_entry::tt_flag::exact));
+        table.new_search();
+
+        // Fill the rest of the bucket with entries of the same depth from the new search
+        for (zobrist_key i = 1; i <= tt_bucket::num_entries; ++i) {
+            const zobrist_key new_key = bucket_key | i;
+            table.store(new_key, tt_entry(new_key, tt_move, 42, 7, tt_entry::tt_flag::exact));
+        }
+
+        CHECK_FALSE(table.probe(bucket_key, probed));
+
+        for (zobrist_key i = 1; i <= tt_bucket::num_entries; ++i)
+            CHECK(table.probe(bucket_key | i, probed));
+    }
+
+    TEST_CASE("save and load") {
+        const auto path =
+            (std::filesystem::temp_directory_path() / "baryonyx_tt_test.bin").string();
+
+        transposition_table table(2);
+        table.store(key, entry);
+        REQUIRE(table.save(path));
+
+        transposition_table loaded_table(1);
+        tt_entry            probed;
+
+        REQUIRE(loaded_table.load(path));
+        CHECK_EQ(loaded_table.size_mb(), 2);
+        REQUIRE(loaded_table.probe(key, probed));
+        CHECK_EQ(probed.move(), entry.move());
+
+        // Headers claiming more buckets than the file holds or the maximum size allows are
+        // rejected without touching the table
+        for (const u64 bucket_count : {u64{1} << 60, ~u64{0}}) {
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(16);
+            file.write(reinterpret_cast<const char*>(&bucket_count), sizeof(bucket_count));
+            file.close();
+
+            CHECK_FALSE(loaded_table.load(path));
+            CHECK_EQ(loaded_table.size_mb(), 2);
+            CHECK(loaded_table.probe(key, probed));
+        }
+
+        // Truncated files are rejected without touching the table
+        std::filesystem::resize_file(path, 1024);
+
+        CHECK_FALSE(loaded_table.load(path));
+        CHECK(loaded_table.probe(key, probed));
+
+        std::filesystem::remove(path);
+    }
+}